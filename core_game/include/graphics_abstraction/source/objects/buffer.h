@@ -7,6 +7,8 @@ namespace graphics_abstraction
 	{
 		unspecified, vertex, indicies, 
 		instanced,   other,
+		//source of the texture data, see texture_builder::source_buffer
+		pixel_unpack,
 	};
 
 	struct buffer : public object
@@ -33,6 +35,8 @@ namespace graphics_abstraction
 				break;
 			case graphics_abstraction::buffer_type::other:
 				break;
+			case graphics_abstraction::buffer_type::pixel_unpack:
+				break;
 			}
 		}
 	public:
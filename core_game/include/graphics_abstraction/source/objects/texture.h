@@ -69,6 +69,11 @@ namespace graphics_abstraction
 		texture_internal_format source_format = texture_internal_format::unspecified;
 		input_data_type source_data_type = input_data_type::unspecified;
 		void* source_texture = nullptr;
+		/*
+			if set, texture data is read from this pixel_unpack buffer
+			and source_texture is treated as an offset into it
+		*/
+		buffer* source_buffer = nullptr;
 
 		texture_filtering min_filter		= texture_filtering::linear;
 		texture_filtering min_mipmap_filter = texture_filtering::linear;
@@ -85,10 +90,13 @@ namespace graphics_abstraction
 
 			if (
 				(source_format == texture_internal_format::unspecified || source_data_type == input_data_type::unspecified) 
-				&& !(source_texture == nullptr)
+				&& !(source_texture == nullptr && source_buffer == nullptr)
 			)
 				goto report_error;
 
+			if (source_buffer != nullptr && source_buffer->get_buffer_type() != buffer_type::pixel_unpack)
+				goto report_error;
+
 			switch (texture_type)
 			{
 			case graphics_abstraction::texture_type::unspecified:
@@ -66,6 +66,8 @@ namespace graphics_abstraction
 						return GL_ARRAY_BUFFER;
 					case graphics_abstraction::buffer_type::other:
 						return GL_ARRAY_BUFFER;
+					case graphics_abstraction::buffer_type::pixel_unpack:
+						return GL_PIXEL_UNPACK_BUFFER;
 					default:
 						return GL_ARRAY_BUFFER;
 					}
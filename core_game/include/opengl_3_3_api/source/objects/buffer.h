@@ -24,7 +24,7 @@ namespace graphics_abstraction
 
 					internal::glGenBuffers(1, &id);
 					internal::glBindBuffer(internal::buffer_type_to_opengl(bt), id);
-					internal::glBufferData(internal::buffer_type_to_opengl(bt), size, NULL, GL_DYNAMIC_DRAW);
+					internal::glBufferData(internal::buffer_type_to_opengl(bt), size, NULL, usage());
 					internal::glBindBuffer(internal::buffer_type_to_opengl(bt), 0);
 				}
 
@@ -44,7 +44,7 @@ namespace graphics_abstraction
 				{
 					size = new_buffer_size;
 					internal::glBindBuffer(internal::buffer_type_to_opengl(buffer_type), id);
-					internal::glBufferData(internal::buffer_type_to_opengl(buffer_type), new_buffer_size, NULL, GL_DYNAMIC_DRAW);
+					internal::glBufferData(internal::buffer_type_to_opengl(buffer_type), new_buffer_size, NULL, usage());
 					internal::glBindBuffer(internal::buffer_type_to_opengl(buffer_type), 0);
 				}
 
@@ -53,6 +53,12 @@ namespace graphics_abstraction
 				{
 					internal::glDeleteBuffers(1, &id);
 				}
+
+				//pixel unpack buffers are written once and read once by the texture upload
+				internal::GLenum usage()
+				{
+					return buffer_type == graphics_abstraction::buffer_type::pixel_unpack ? GL_STREAM_DRAW : GL_DYNAMIC_DRAW;
+				}
 			};
 
 			struct buffer_builder : public graphics_abstraction::buffer_builder
@@ -2,6 +2,7 @@
 #include "graphics_abstraction.h"
 #include "../common/opengl.h"
 #include "../common/mappings.h"
+#include "buffer.h"
 
 namespace graphics_abstraction
 {
@@ -101,7 +102,17 @@ namespace graphics_abstraction
 						internal::glTexParameteri(txt_type, GL_TEXTURE_MAG_FILTER,
 							internal::texture_filtering_type_to_opengl(0, tb.mag_filter, tb.mag_filter));
 
-						write(width, height, tb.source_texture, tb.source_format, tb.source_data_type);
+						if (tb.source_buffer != nullptr)
+						{
+							//rows in pixel unpack buffers are tightly packed
+							internal::glBindBuffer(GL_PIXEL_UNPACK_BUFFER, static_cast<buffer*>(tb.source_buffer)->id);
+							internal::glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+							write(width, height, tb.source_texture, tb.source_format, tb.source_data_type);
+							internal::glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+							internal::glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+						}
+						else
+							write(width, height, tb.source_texture, tb.source_format, tb.source_data_type);
 
 						if (tb.generate_mipmaps)
 							internal::glGenerateMipmap(internal::texture_type_type_to_opengl(texture_type));
@@ -8,9 +8,12 @@
 #include "source/input/input_manager.h"
 #include "source/window/window_manager.h"
 #include "source/filesystem/filesystem.h"
+#include "source/filesystem/mounts.h"
 #include "source/mods/mods_manager.h"
 #include "source/physics/dynamics_manager.h"
+#include "source/events/event_bus.h"
 #include "source/audio/audio_manager.h"
+#include "source/components/tilemap.h"
 
 #include "source/common/crash.h"
 
@@ -27,10 +30,18 @@ constexpr double frame_time = (60.0f / 1000.0f);
 #include "debug_config.h"
 #endif
 
-int main()
+int main(int argc, char* argv[])
 {
 	try
 	{
+		//Pack directory into a single file, which can be shipped instead of the loose files
+		//usage: --pack [directory] [pack file] [--lz4]
+		if (argc >= 4 && std::string(argv[1]) == "--pack")
+		{
+			filesystem::create_pack(argv[2], argv[3], argc >= 5 && std::string(argv[4]) == "--lz4");
+			return 0;
+		}
+
 		common::window_manager->create_window("Simple Game Engine", 16 * 80, 9 * 80, false);
 		common::renderer->initialize();
 		common::window_manager->set_resize_callback(common::renderer->get_resize_function());
@@ -85,6 +96,11 @@ int main()
 				break;
 			};
 
+#ifdef _DEBUG
+			//Reload assets modified on disk
+			common::assets_manager->reload_modified_assets();
+#endif
+
 			//Update flipbooks channels positions
 			common::flipbooks_manager->update();
 
@@ -96,9 +112,19 @@ int main()
 			common::input_mananger->update_mappings_states();
 			common::behaviors_manager->call_update_functions();
 
+			//Apply kills and other structural changes requested by the game logic
+			common::world->flush_commands();
+
 			//Apply physics
 			common::dynamics_manager->update();
 
+			//Deliver collisions and other events queued during logic and physics
+			common::event_bus->dispatch();
+			common::world->flush_commands();
+
+			//Stream infinite tilemaps chunks around the camera
+			entities::components::tilemap::update_streamed_tilemaps();
+
 			//Rendering
 			common::renderer->update_transformations();
 			common::renderer->render();
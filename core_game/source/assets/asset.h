@@ -13,6 +13,14 @@ namespace assets
 	{
 		std::string package_name;
 		virtual ~asset() {};
+		/*
+			hot_swap
+			takes over the content of a freshly loaded version of the same asset,
+			so everything already holding this asset sees the new data
+			the fresh asset receives the old content and frees it when destroyed
+			returns false if the asset type cannot be reloaded in place
+		*/
+		virtual bool hot_swap(asset& fresh) { return false; };
 	};
 
 	template <class derived>
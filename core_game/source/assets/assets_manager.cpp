@@ -1,6 +1,8 @@
 #include "assets_manager.h"
 
 #include "source/filesystem/filesystem.h"
+#include "source/filesystem/file_watcher.h"
+#include "source/filesystem/mounts.h"
 
 #include "source/common/crash.h"
 #include "include/nlohmann/json.hpp"
@@ -8,7 +10,12 @@
 #include "source/utilities/hash_string.h"
 #include "source/assets/load_asset.h"
 
+#include "source/common/common.h"
+#include "source/rendering/renderer.h"
+#include "graphics_abstraction/graphics_abstraction.h"
+
 #include <unordered_map>
+#include <set>
 
 using namespace assets;
 
@@ -23,6 +30,21 @@ struct assets_manager::implementation
     //assets that are kept alive by asset_manager
     //to add / remove to this vector use lock_asset / unlock_asset
     std::unordered_map<uint32_t, std::shared_ptr<asset>> locked_assets;
+    //watches the mod directory, so modified assets can be reloaded
+    filesystem::file_watcher watcher;
+    //normalized global path of a file to paths of the assets loaded from it
+    std::unordered_map<std::string, std::set<std::string>> sources;
+
+    /*
+        create_asset
+        loads asset from the disk without registering it
+        -l-
+        [decoded_image] image decoded ahead, used by image assets instead of loading one
+        [pixel_buffer] pixel unpack buffer used to upload the image
+    */
+    std::shared_ptr<asset> create_asset(const std::string& path, const nlohmann::json& header,
+        std::shared_ptr<filesystem::image_file> decoded_image = nullptr, graphics_abstraction::buffer* pixel_buffer = nullptr);
+    void register_asset(const std::string& path, const std::shared_ptr<asset>& new_asset);
 };
 
 assets_manager::assets_manager()
@@ -61,14 +83,13 @@ std::weak_ptr<asset> assets_manager::safe_get_asset(std::string path)
     return get_asset(utilities::hash_string(path));
 }
 
-void assets_manager::load_asset(std::string path)
+//reads asset header and checks its asset_type
+static nlohmann::json load_header(const std::string& path)
 {
-    auto file = filesystem::load_file(path + ".json");
-    if (file.fail())
+    if (!filesystem::file_exists(path + ".json"))
         error_handling::crash(error_handling::error_source::core, "[asset_manager::load_asset]", "Missing asset: " + path); 
 
-    nlohmann::json data = nlohmann::json::parse(file);
-    file.close();
+    nlohmann::json data = nlohmann::json::parse(filesystem::load_file_data(path + ".json"));
 
     if (!data.contains("asset_type"))
         error_handling::crash(error_handling::error_source::core, 
@@ -80,17 +101,54 @@ void assets_manager::load_asset(std::string path)
         error_handling::crash(error_handling::error_source::core,
             "[asset_manager::load_asset]", "Invalid asset: " + path + " asset_type should be string");
 
-    std::string asset_type;
-    at.get_to(asset_type);
-    uint32_t hashed_asset_type = utilities::hash_string(asset_type);
+    return data;
+}
+
+//returns hashed asset type of asset whose image can be decoded ahead, 0 otherwise
+static uint32_t get_image_asset_type(const nlohmann::json& header)
+{
+    uint32_t hashed_asset_type = utilities::hash_string(header.at("asset_type").get<std::string>());
+    switch (hashed_asset_type)
+    {
+    case utilities::hash_string("texture"):
+    case utilities::hash_string("sprite_sheet"):
+    case utilities::hash_string("flipbook"):
+    case utilities::hash_string("tileset"):
+        if (header.contains("path") && header.at("path").is_string())
+            return hashed_asset_type;
+    }
+    return 0;
+}
+
+std::shared_ptr<asset> assets_manager::implementation::create_asset(const std::string& path, const nlohmann::json& data,
+    std::shared_ptr<filesystem::image_file> decoded_image, graphics_abstraction::buffer* pixel_buffer)
+{
+    uint32_t hashed_asset_type = utilities::hash_string(data.at("asset_type").get<std::string>());
 
     loading::load_data load_data;
     load_data.header_data = &data;
     load_data.package = filesystem::get_package(path);
+    load_data.decoded_image = std::move(decoded_image);
+    load_data.pixel_buffer = pixel_buffer;
 
     filesystem::set_active_assets_directory(filesystem::get_owning_folder(path));
     filesystem::set_active_assets_directory_enabled(true);
 
+    if (watcher.is_watching())
+    {
+        //remember which files the asset was built from, so it can be reloaded when any of them changes
+        //packed files never change, so only loose ones are remembered
+        auto remember_source = [&](const std::string& source_path)
+        {
+            std::string global_path = filesystem::get_mounted_loose_path(filesystem::resolve_path(source_path));
+            if (!global_path.empty())
+                sources[filesystem::normalize_path(global_path)].insert(path);
+        };
+        remember_source(path + ".json");
+        if (data.contains("path") && data.at("path").is_string() && !data.at("path").get<std::string>().empty())
+            remember_source(create_path(data.at("path"), load_data.package));
+    }
+
     std::shared_ptr<asset> new_asset = nullptr;
     switch (hashed_asset_type)
     {
@@ -136,6 +194,9 @@ void assets_manager::load_asset(std::string path)
     case utilities::hash_string("custom_data"):
         new_asset = loading::load_custom_data(load_data);
         break;
+    case utilities::hash_string("prefab"):
+        new_asset = loading::load_prefab(load_data);
+        break;
     default:
         error_handling::crash(error_handling::error_source::core,
             "[asset_manager::load_asset]", "Invalid asset: " + path + " invalid asset_type");
@@ -148,15 +209,139 @@ void assets_manager::load_asset(std::string path)
             "[asset_manager::load_asset]", "Failed to load asset: " + path);
 
     new_asset->package_name = path;
+    return new_asset;
+}
 
+void assets_manager::implementation::register_asset(const std::string& path, const std::shared_ptr<asset>& new_asset)
+{
     uint32_t hash = utilities::hash_string(path);
 
-    if (impl->assets.find(hash) == impl->assets.end())
-        impl->assets.insert({ hash, new_asset });
+    if (assets.find(hash) == assets.end())
+        assets.insert({ hash, new_asset });
     else
-        impl->assets.at(hash) = new_asset;
+        assets.at(hash) = new_asset;
+
+    new_assets.push_back(new_asset);
+}
+
+void assets_manager::load_asset(std::string path)
+{
+    impl->register_asset(path, impl->create_asset(path, load_header(path)));
+}
+
+void assets_manager::load_assets(const std::vector<std::string>& paths)
+{
+    std::vector<nlohmann::json> headers;
+    headers.reserve(paths.size());
 
-    impl->new_assets.push_back(new_asset);
+    //resolved paths of the images to decode and indices of the assets using them
+    std::vector<std::string> images_paths;
+    std::vector<size_t> images_owners;
+
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        headers.push_back(load_header(paths[i]));
+        if (get_image_asset_type(headers.back()) == 0)
+            continue;
+
+        filesystem::set_active_assets_directory(filesystem::get_owning_folder(paths[i]));
+        filesystem::set_active_assets_directory_enabled(true);
+        std::string image_path = create_path(headers.back().at("path"), filesystem::get_package(paths[i]));
+        images_paths.push_back(filesystem::resolve_path(image_path));
+        filesystem::set_active_assets_directory_enabled(false);
+
+        images_owners.push_back(i);
+    }
+
+    //images are uploaded through a single pixel unpack buffer, 
+    //which is orphaned before every upload, so uploads do not wait for each other
+    auto api = common::renderer->get_api();
+    graphics_abstraction::buffer* pixel_buffer = nullptr;
+    if (!images_paths.empty())
+    {
+        auto bb = api->create_buffer_builder();
+        bb->buffer_type = graphics_abstraction::buffer_type::pixel_unpack;
+        bb->size = 4;
+        pixel_buffer = reinterpret_cast<graphics_abstraction::buffer*>(api->build(bb));
+    }
+
+    std::vector<bool> loaded(paths.size(), false);
+    try
+    {
+        //images are uploaded as soon as they are decoded, while the next ones are still being decoded
+        filesystem::load_images(images_paths, [&](size_t index, std::unique_ptr<filesystem::image_file> image)
+        {
+            size_t owner = images_owners[index];
+            impl->register_asset(paths[owner], impl->create_asset(paths[owner], headers[owner], std::move(image), pixel_buffer));
+            loaded[owner] = true;
+        });
+    }
+    catch (...)
+    {
+        if (pixel_buffer != nullptr)
+            api->free(pixel_buffer);
+        throw;
+    }
+
+    if (pixel_buffer != nullptr)
+        api->free(pixel_buffer);
+
+    for (size_t i = 0; i < paths.size(); i++)
+        if (!loaded[i])
+            impl->register_asset(paths[i], impl->create_asset(paths[i], headers[i]));
+}
+
+void assets_manager::watch_directory(const std::string& directory)
+{
+    impl->sources.clear();
+    impl->watcher.watch(directory);
+}
+
+void assets_manager::stop_watching()
+{
+    impl->sources.clear();
+    impl->watcher.stop();
+}
+
+void assets_manager::reload_modified_assets()
+{
+    if (!impl->watcher.is_watching())
+        return;
+
+    for (auto& file : impl->watcher.poll())
+    {
+        auto itr = impl->sources.find(file);
+        if (itr == impl->sources.end())
+            continue;
+
+        //copy, as create_asset may add new sources
+        std::set<std::string> dependent_assets = itr->second;
+        for (auto& path : dependent_assets)
+        {
+            auto current = impl->assets.find(utilities::hash_string(path));
+            if (current == impl->assets.end() || current->second.expired())
+                continue;   //not loaded, so the next load will read the new version anyway
+
+            //file may be saved mid-edit, so a broken one is reported and the old version is kept
+            std::shared_ptr<asset> fresh;
+            try
+            {
+                error_handling::recoverable_scope scope;
+                fresh = impl->create_asset(path, load_header(path));
+            }
+            catch (const std::exception& e)
+            {
+                error_handling::show_crash_info("[core][assets_manager::reload_modified_assets]:\n" + path 
+                    + " could not be reloaded, the previous version is kept.\n" + e.what());
+                continue;
+            }
+
+            //assets which can't be swapped in place keep the old version until the mod is reloaded
+            if (!current->second.lock()->hot_swap(*fresh))
+                error_handling::show_crash_info("[core][assets_manager::reload_modified_assets]:\n" + path
+                    + " cannot be reloaded in place, reload the mod to see the changes.");
+        }
+    }
 }
 
 void assets_manager::unload_unreferenced_assets()
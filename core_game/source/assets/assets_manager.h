@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "source/assets/asset.h"
 
@@ -17,6 +18,12 @@ namespace assets
 		void load_required_core_assets();
 
 		void load_asset(std::string local_path);
+		/*
+			load_assets
+			loads many assets at once
+			images of texture assets are decoded in parallel and uploaded while the rest is being decoded
+		*/
+		void load_assets(const std::vector<std::string>& local_paths);
 		std::weak_ptr<asset> get_asset(uint32_t hashed_name);
 		std::weak_ptr<asset> safe_get_asset(std::string path);
 
@@ -24,5 +31,19 @@ namespace assets
 		void unlock_asset(uint32_t hashed_name);
 
 		void unload_unreferenced_assets();
+
+		/*
+			watch_directory
+			starts watching given directory for modified files
+			assets loaded from modified files are reloaded by reload_modified_assets
+		*/
+		void watch_directory(const std::string& directory);
+		void stop_watching();
+		/*
+			reload_modified_assets
+			reloads in place loaded assets whose files were modified since the last call
+			asset failing to load, or one which cannot be swapped in place, is reported and keeps its previous version
+		*/
+		void reload_modified_assets();
 	};
 }
\ No newline at end of file
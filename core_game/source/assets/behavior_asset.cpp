@@ -2,12 +2,29 @@
 #include "source/common/common.h"
 #include "source/behaviors/behaviors_manager.h"
 
-assets::behavior::behavior(std::string& lua_file_path)
+assets::behavior::behavior(std::string& lua_file_path, bool _low_priority)
+    : low_priority(_low_priority)
 {
     name = common::behaviors_manager->create_functions_table(lua_file_path);
+    common::behaviors_manager->create_function_refs(name, function_refs);
+    stats = common::behaviors_manager->get_behavior_stats(lua_file_path);
 }
 
 assets::behavior::~behavior()
 {
+    common::behaviors_manager->destroy_function_refs(function_refs);
     common::behaviors_manager->destroy_functions_table(name);
+}
+
+bool assets::behavior::hot_swap(asset& fresh)
+{
+    auto other = dynamic_cast<behavior*>(&fresh);
+    if (other == nullptr)
+        return false;
+    //behavior components call functions through the asset refs
+    //so swapping them is enough to make components use the new functions
+    std::swap(name, other->name);
+    std::swap(function_refs, other->function_refs);
+    std::swap(low_priority, other->low_priority);
+    return true;
 }
\ No newline at end of file
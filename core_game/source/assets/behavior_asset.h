@@ -1,5 +1,8 @@
 #pragma once
 #include "asset.h"
+#include "source/behaviors/behavior_functions.h"
+#include "source/behaviors/behavior_stats.h"
+#include <memory>
 
 namespace behaviors
 {
@@ -14,7 +17,13 @@ namespace assets
 	protected:
 		std::string name;
 	public:
-		behavior(std::string& lua_file_path);
+		behaviors::function_refs function_refs;
+		//shared by all assets loaded from the same file
+		std::shared_ptr<behaviors::behavior_stats> stats;
+		//low priority behaviors can be deferred when the frame budget is exceeded
+		bool low_priority = false;
+		behavior(std::string& lua_file_path, bool _low_priority = false);
 		~behavior();
+		virtual bool hot_swap(asset& fresh) override;
 	};
 }
\ No newline at end of file
@@ -13,5 +13,13 @@ namespace assets
 	public:
 		custom_data(std::unique_ptr<nlohmann::json>& data) : _data(std::move(data)) {};
 		std::shared_ptr<nlohmann::json> access_data() { return _data; };
+		virtual bool hot_swap(asset& fresh) override
+		{
+			auto other = dynamic_cast<custom_data*>(&fresh);
+			if (other == nullptr)
+				return false;
+			std::swap(_data, other->_data);
+			return true;
+		};
 	};
 }
\ No newline at end of file
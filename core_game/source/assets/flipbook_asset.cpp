@@ -1,10 +1,14 @@
 #include "flipbook_asset.h"
 
+#include <algorithm>
+#include <typeinfo>
+
 namespace assets
 {
 	flipbook::flipbook(filesystem::image_file* data, unsigned int _sprite_width, 
-		unsigned int _sprite_height, std::map<uint32_t, animation> _animations)
-		: sprite_sheet(data, _sprite_width, _sprite_height), animations(_animations)
+		unsigned int _sprite_height, std::map<uint32_t, animation> _animations,
+		graphics_abstraction::buffer* pixel_buffer)
+		: sprite_sheet(data, _sprite_width, _sprite_height, pixel_buffer), animations(_animations)
 	{
 	}
 
@@ -12,6 +16,20 @@ namespace assets
 	{
 	}
 
+	bool flipbook::hot_swap(asset& fresh)
+	{
+		if (typeid(fresh) != typeid(*this))
+			return false;
+		auto& other = static_cast<flipbook&>(fresh);
+		auto same_animation = [](const std::pair<const uint32_t, animation>& a, const std::pair<const uint32_t, animation>& b)
+		{
+			return a.first == b.first && a.second.frames_per_second == b.second.frames_per_second && a.second.frames == b.second.frames;
+		};
+		if (!std::equal(animations.begin(), animations.end(), other.animations.begin(), other.animations.end(), same_animation))
+			return false;
+		return sprite_sheet::hot_swap(fresh);
+	}
+
 	int flipbook::get_sprite_id_at_position(uint32_t animation_id, float playback_position)
 	{
 		auto& animation = animations.at(animation_id);
@@ -17,8 +17,14 @@ namespace assets
 		const std::map<uint32_t, animation> animations;
 
 		flipbook(filesystem::image_file* data, unsigned int _sprite_width, 
-			unsigned int _sprite_height, std::map<uint32_t, animation> _animations);
+			unsigned int _sprite_height, std::map<uint32_t, animation> _animations,
+			graphics_abstraction::buffer* pixel_buffer = nullptr);
 		virtual ~flipbook();
+		/*
+			hot_swap
+			swaps only the image, changed animations or sprite sizes require reloading the mod
+		*/
+		virtual bool hot_swap(asset& fresh) override;
 
 		/*
 			get_sprite_id_at_position
@@ -9,7 +9,6 @@
 #include "sprite_sheet.h"
 #include "flipbook_asset.h"
 #include "tileset_asset.h"
-#include "tilemap_asset.h"
 #include "sound_asset.h"
 #include "behavior_asset.h"
 #include "scene_asset.h"
@@ -18,8 +17,10 @@
 #include "input_config_asset.h"
 #include "collision_config_asset.h"
 #include "custom_data_assset.h"
+#include "prefab_asset.h"
 
 #include <fstream>
+#include <limits>
 
 std::string create_path(const std::string& path, const std::string& package)
 {
@@ -28,6 +29,13 @@ std::string create_path(const std::string& path, const std::string& package)
 	return package + path;
 }
 
+std::shared_ptr<filesystem::image_file> get_image(const assets::loading::load_data& ld, const std::string& path)
+{
+	if (ld.decoded_image != nullptr)
+		return ld.decoded_image;
+	return filesystem::load_image(path);
+}
+
 namespace assets
 {
 	namespace loading
@@ -41,9 +49,9 @@ namespace assets
 					"Invalid/Missing image path");
 
 			std::string source_path = create_path(header.at("path"), ld.package);
-			auto image = filesystem::load_image(source_path);
+			auto image = get_image(ld, source_path);
 
-			auto texture_asset = std::make_shared<assets::texture>(image.get());
+			auto texture_asset = std::make_shared<assets::texture>(image.get(), ld.pixel_buffer);
 			return texture_asset;
 		}
 
@@ -58,7 +66,7 @@ namespace assets
 					"Invalid/Missing image path");
 
 			std::string source_path = create_path(header.at("path"), ld.package);
-			auto image = filesystem::load_image(source_path);
+			auto image = get_image(ld, source_path);
 
 			if (!(header.contains("sprite_width") && header.at("sprite_width").is_number_integer()))
 				error_handling::crash(error_handling::error_source::core, "[loading::load_sprite_sheet]",
@@ -72,7 +80,7 @@ namespace assets
 
 			unsigned int sprite_height = header.at("sprite_height");
 
-			sprite_sheet_asset = std::make_shared<assets::sprite_sheet>(image.get(), sprite_width, sprite_height);
+			sprite_sheet_asset = std::make_shared<assets::sprite_sheet>(image.get(), sprite_width, sprite_height, ld.pixel_buffer);
 
 			return sprite_sheet_asset;
 		}
@@ -86,7 +94,7 @@ namespace assets
 					"Invalid/Missing image path");
 
 			std::string source_path = create_path(header.at("path"), ld.package);
-			auto image = filesystem::load_image(source_path);
+			auto image = get_image(ld, source_path);
 
 			if (!(header.contains("sprite_width") && header.at("sprite_width").is_number_integer()))
 				error_handling::crash(error_handling::error_source::core, "[loading::load_flipbook]",
@@ -129,7 +137,7 @@ namespace assets
 				animations.insert({utilities::hash_string(name), std::move(anim)});
 			}
 
-			auto flipbook_asset = std::make_shared<assets::flipbook>(image.get(), sprite_width, sprite_height, animations);
+			auto flipbook_asset = std::make_shared<assets::flipbook>(image.get(), sprite_width, sprite_height, animations, ld.pixel_buffer);
 			return flipbook_asset;
 		}
 
@@ -141,7 +149,7 @@ namespace assets
 				error_handling::crash(error_handling::error_source::core, "[loading::load_tileset]",
 					"Invalid/Missing image path");
 			std::string source_path = create_path(header.at("path"), ld.package);
-			auto image = filesystem::load_image(source_path);
+			auto image = get_image(ld, source_path);
 
 			if (!(header.contains("tile_width") && header.at("tile_width").is_number_integer()))
 				error_handling::crash(error_handling::error_source::core, "[loading::load_tileset]",
@@ -165,71 +173,10 @@ namespace assets
 				layers.push_back(tile_id);
 			}
 
-			auto tileset_asset = std::make_shared<assets::tileset>(image.get(), tile_width, tile_height, layers);
+			auto tileset_asset = std::make_shared<assets::tileset>(image.get(), tile_width, tile_height, layers, ld.pixel_buffer);
 			return tileset_asset;
 		}
 
-		std::shared_ptr<asset> load_tilemap(const load_data& ld)
-		{
-			auto& header = *ld.header_data;
-
-			if (!(header.contains("path") && header.at("path").is_string()))
-				error_handling::crash(error_handling::error_source::core, "[loading::load_tilemap]",
-					"Invalid/Missing path");
-
-			std::string file_path = create_path(header.at("path"), ld.package);
-			auto file = filesystem::load_file(file_path);
-			if (file.fail())
-				error_handling::crash(error_handling::error_source::core, "[loading::load_tilemap]", 
-					"Missing .tmj tilemap: " + header.at("path"));
-			nlohmann::json source = nlohmann::json::parse(file);
-			file.close();
-
-			if (!(source.contains("width") && source.at("width").is_number_integer()))
-				error_handling::crash(error_handling::error_source::core, "[loading::load_tilemap]",
-					"Source file is missing width");
-			unsigned int width = source.at("width");
-
-			if (!(source.contains("height") && source.at("height").is_number_integer()))
-				error_handling::crash(error_handling::error_source::core, "[loading::load_tilemap]",
-					"Source file is missing height");
-			unsigned int height = source.at("height");
-
-			std::vector<tilemap::layer> layers;
-			if (!(source.contains("layers") && source.at("layers").is_array()))
-				error_handling::crash(error_handling::error_source::core, "[loading::load_tilemap]",
-					"Source file is missing layers");
-
-			int layers_iterator = 0;
-			for (auto& layer : source.at("layers"))
-			{
-				if (!layer.is_object()) 
-					error_handling::crash(error_handling::error_source::core, "[loading::load_tilemap]","Invalid layer");
-
-				if (!(layer.contains("data") && layer.at("data").is_array()))
-					continue; //Ignore object layers
-
-				layers.push_back({});
-
-				tilemap::row current_row;
-				for (auto& tile : layer.at("data"))
-				{
-					if (current_row.size() == width)
-					{
-						layers.at(layers_iterator).push_back(std::move(current_row));
-						current_row = {};
-					}
-					current_row.push_back(tile);
-				}
-				layers.at(layers_iterator).push_back(std::move(current_row));
-				layers_iterator++;
-			}
-
-			std::shared_ptr<asset> tilemap_asset 
-				= std::make_shared<assets::tilemap>(width, height, layers);
-			return tilemap_asset;
-		}
-
 		std::shared_ptr<asset> load_shader(const load_data& ld)
 		{
 			auto& header = *ld.header_data;
@@ -243,14 +190,7 @@ namespace assets
 					"Invalid/Missing shader path");
 
 			std::string source_path = create_path(header.at("path"), ld.package);
-			auto source_file = filesystem::load_file(source_path);
-
-			source_file.seekg(0, std::ios::end);
-			size_t size = source_file.tellg();
-			std::string source(size, ' ');
-			source_file.seekg(0);
-			source_file.read(&source[0], size);
-			source_file.close();
+			std::string source = filesystem::load_file_data(source_path);
 
 			//seek start
 			int i = 0;
@@ -322,7 +262,16 @@ namespace assets
 
 			std::string source_path = create_path(header.at("path"), ld.package);
 
-			auto behavior_asset = std::make_shared<assets::behavior>(source_path);	
+			bool low_priority = false;
+			if (header.contains("low_priority"))
+			{
+				if (!header.at("low_priority").is_boolean())
+					error_handling::crash(error_handling::error_source::core, "[loading::load_behavior]",
+						"low_priority should be a boolean");
+				low_priority = header.at("low_priority");
+			}
+
+			auto behavior_asset = std::make_shared<assets::behavior>(source_path, low_priority);
 			return behavior_asset;
 		}
 
@@ -349,14 +298,7 @@ namespace assets
 					"Invalid/Missing mesh path");
 
 			std::string source_path = create_path(header.at("path"), ld.package);
-			std::fstream source_file = filesystem::load_file(source_path);
-
-			source_file.seekg(0, std::ios::end);
-			size_t size = source_file.tellg();
-			std::string source(size, ' ');
-			source_file.seekg(0);
-			source_file.read(&source[0], size);
-			source_file.close();
+			std::string source = filesystem::load_file_data(source_path);
 
 			int i = 0;
 
@@ -634,5 +576,120 @@ namespace assets
 			auto asset = std::make_shared<assets::custom_data>(owned_copy);
 			return asset;
 		}
+
+		std::shared_ptr<asset> load_prefab(const load_data& ld)
+		{
+			auto& header = *ld.header_data;
+
+			auto crash = [](const std::string& message)
+			{
+				error_handling::crash(error_handling::error_source::core, "[loading::load_prefab]", message);
+			};
+
+			//ids can be given as integers or names, as in lua
+			auto load_id = [&](const nlohmann::json& value, const std::string& id_of_what) -> uint32_t
+			{
+				if (value.is_number_integer())
+					return value.get<uint32_t>();
+				if (value.is_string())
+					return utilities::hash_string(value.get<std::string>());
+				crash(id_of_what + " should be an integer or a string");
+				return 0;
+			};
+
+			auto load_string = [&](const nlohmann::json& component, const char* name) -> std::string
+			{
+				if (!(component.contains(name) && component.at(name).is_string()))
+					crash(std::string("Invalid/Missing ") + name);
+				return component.at(name);
+			};
+
+			//prefab is resolved when it is spawned, so "$/" paths are resolved now, while its folder is active
+			auto load_asset_path = [&](const nlohmann::json& component, const char* name) -> std::string
+			{
+				return filesystem::resolve_path(create_path(load_string(component, name), ld.package));
+			};
+
+			auto load_number = [&](const nlohmann::json& component, const char* name) -> float
+			{
+				if (!(component.contains(name) && component.at(name).is_number()))
+					crash(std::string("Invalid/Missing ") + name);
+				return component.at(name);
+			};
+
+			uint8_t layer = 0;
+			if (header.contains("layer"))
+			{
+				if (!header.at("layer").is_number_integer())
+					crash("layer should be an integer");
+				int64_t value = header.at("layer").get<int64_t>();
+				if (value < 0 || value > std::numeric_limits<uint8_t>::max())
+					crash("layer should be between 0 and " + std::to_string(std::numeric_limits<uint8_t>::max()) 
+						+ ", got " + std::to_string(value));
+				layer = static_cast<uint8_t>(value);
+			}
+
+			if (!(header.contains("components") && header.at("components").is_array()))
+				crash("Invalid/Missing components");
+
+			std::vector<prefab::component> components;
+			for (auto& c : header.at("components"))
+			{
+				if (!(c.is_object() && c.contains("type") && c.contains("id")))
+					crash("Each component should be an object containing type and id");
+
+				prefab::component component;
+				component.id = load_id(c.at("id"), "Component id");
+
+				switch (utilities::hash_string(load_string(c, "type")))
+				{
+				case utilities::hash_string("behavior"):
+					component.type = entities::component_type::behavior;
+					component.asset_path = load_asset_path(c, "behavior");
+					break;
+				case utilities::hash_string("camera"):
+					component.type = entities::component_type::camera;
+					component.width = load_number(c, "width");
+					break;
+				case utilities::hash_string("collider"):
+					component.type = entities::component_type::collider;
+					component.preset_name = utilities::hash_string(load_string(c, "preset"));
+					if (!(c.contains("extend") && c.at("extend").is_array() && c.at("extend").size() == 2 
+						&& c.at("extend")[0].is_number() && c.at("extend")[1].is_number()))
+						crash("Collider extend should be an array of two numbers");
+					component.extend = { c.at("extend")[0].get<float>(), c.at("extend")[1].get<float>() };
+					break;
+				case utilities::hash_string("dynamics"):
+					component.type = entities::component_type::dynamics;
+					break;
+				case utilities::hash_string("flipbook"):
+					component.type = entities::component_type::flipbook;
+					component.asset_path = load_asset_path(c, "flipbook");
+					component.preset_name = utilities::hash_string(load_string(c, "preset"));
+					if (!c.contains("animation"))
+						crash("Invalid/Missing animation");
+					component.animation = load_id(c.at("animation"), "Animation");
+					break;
+				case utilities::hash_string("listener"):
+					component.type = entities::component_type::listener;
+					break;
+				case utilities::hash_string("sound_emitter"):
+					component.type = entities::component_type::sound_emitter;
+					break;
+				case utilities::hash_string("sprite"):
+					component.type = entities::component_type::sprite;
+					component.asset_path = load_asset_path(c, "texture");
+					component.preset_name = utilities::hash_string(load_string(c, "preset"));
+					if (c.contains("sprite_id"))
+						component.sprite_id = static_cast<int>(load_number(c, "sprite_id"));
+					break;
+				default:
+					crash("Invalid component type, prefabs can contain behavior, camera, collider, dynamics, flipbook, listener, sound_emitter and sprite components");
+				}
+				components.push_back(std::move(component));
+			}
+
+			return std::make_shared<assets::prefab>(layer, components);
+		}
 	}
 }
\ No newline at end of file
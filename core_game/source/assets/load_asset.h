@@ -3,6 +3,25 @@
 #include <memory>
 #include "nlohmann/json.hpp"
 
+namespace filesystem
+{
+	struct image_file;
+}
+
+namespace graphics_abstraction
+{
+	struct buffer;
+}
+
+/*
+	create_path
+	returns path of the file referenced from the asset header
+	-l-
+	[path] path from the header, relative to the package or starting with "$"
+	[package] package of the asset
+*/
+std::string create_path(const std::string& path, const std::string& package);
+
 namespace assets
 {
 	namespace loading
@@ -12,6 +31,10 @@ namespace assets
 			const nlohmann::json* header_data;
 			std::string package;
 			std::string header_folder;
+			//image decoded ahead by the batch loader, loaded from the disk if nullptr
+			std::shared_ptr<filesystem::image_file> decoded_image = nullptr;
+			//pixel_unpack buffer used to upload textures, if any
+			graphics_abstraction::buffer* pixel_buffer = nullptr;
 		};
 
 		std::shared_ptr<asset> load_texture(const load_data& data);
@@ -28,5 +51,6 @@ namespace assets
 		std::shared_ptr<asset> load_input_config(const load_data& data);
 		std::shared_ptr<asset> load_collision_config(const load_data& data);
 		std::shared_ptr<asset> load_custom_data(const load_data& data);
+		std::shared_ptr<asset> load_prefab(const load_data& data);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,368 @@
+#include "load_asset.h"
+
+#include "source/common/crash.h"
+#include "source/filesystem/filesystem.h"
+#include "source/filesystem/inflate.h"
+
+#include "tilemap_asset.h"
+
+#include <climits>
+#include <array>
+
+/*
+	Tiled maps are parsed with a sax parser, so the map never exists as a json tree,
+	tiles go straight into flat chunk arrays
+*/
+
+//tiled stores flipping flags in the highest bits of the tile id
+constexpr uint32_t tile_id_mask = 0x0FFFFFFF;
+
+static void crash(const std::string& message)
+{
+	error_handling::crash(error_handling::error_source::core, "[loading::load_tilemap]", message);
+}
+
+static std::string decode_base64(const std::string& encoded)
+{
+	static const auto table = []()
+	{
+		std::array<int8_t, 256> t;
+		t.fill(-1);
+		const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		for (int i = 0; i < 64; i++)
+			t[static_cast<uint8_t>(alphabet[i])] = static_cast<int8_t>(i);
+		return t;
+	}();
+
+	std::string decoded;
+	decoded.reserve(encoded.size() / 4 * 3);
+
+	uint32_t buffer = 0;
+	int buffered_bits = 0;
+	for (char c : encoded)
+	{
+		if (c == '=')
+			break;
+		int8_t value = table[static_cast<uint8_t>(c)];
+		if (value < 0)
+		{
+			//tiled may break long strings
+			if (c == '\n' || c == '\r' || c == ' ')
+				continue;
+			crash("Invalid base64 layer data");
+		}
+		buffer = (buffer << 6) | static_cast<uint32_t>(value);
+		buffered_bits += 6;
+		if (buffered_bits >= 8)
+		{
+			buffered_bits -= 8;
+			decoded.push_back(static_cast<char>((buffer >> buffered_bits) & 0xFF));
+		}
+	}
+	return decoded;
+}
+
+static std::vector<uint32_t> decode_tiles(
+	const std::string& encoded, const std::string& encoding, const std::string& compression, size_t tiles_amount)
+{
+	if (encoding != "base64")
+		crash("Layer data stored as a string has to be base64 encoded");
+
+	std::string bytes = decode_base64(encoded);
+
+	if (compression == "zlib" || compression == "gzip")
+	{
+		std::string inflated;
+		if (!filesystem::inflate(bytes.data(), bytes.size(), inflated, tiles_amount * sizeof(uint32_t)))
+			crash("Corrupted " + compression + " layer data");
+		bytes = std::move(inflated);
+	}
+	else if (compression == "zstd")
+		crash("zstd compressed layers aren't supported, use zlib or gzip compression");
+	else if (!compression.empty())
+		crash("Unknown layer compression: " + compression);
+
+	if (bytes.size() != tiles_amount * sizeof(uint32_t))
+		crash("Layer data size doesn't match its dimensions");
+
+	std::vector<uint32_t> tiles(tiles_amount);
+	auto data = reinterpret_cast<const uint8_t*>(bytes.data());
+	for (size_t i = 0; i < tiles_amount; i++, data += 4)
+		tiles[i] = (data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24)) & tile_id_mask;
+	return tiles;
+}
+
+struct tilemap_sax
+{
+	using json = nlohmann::json;
+
+	enum class frame
+	{
+		root, layers, layer, chunks, chunk, data, skipped
+	};
+
+	struct pending_chunk
+	{
+		assets::tilemap::chunk chunk;
+		//base64 data, decoded once the layer encoding is known
+		std::string encoded;
+		bool has_data = false;
+	};
+
+	struct pending_layer
+	{
+		pending_chunk whole;
+		std::vector<pending_chunk> chunks;
+		std::string encoding = "csv";
+		std::string compression;
+	};
+
+	std::vector<frame> frames;
+	std::string current_key;
+	std::vector<pending_layer> pending_layers;
+	std::vector<uint32_t>* data_target = nullptr;
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+	bool has_width = false;
+	bool has_height = false;
+	bool has_layers = false;
+	bool infinite = false;
+	std::vector<assets::tilemap::layer> layers;
+
+	frame top() { return frames.empty() ? frame::skipped : frames.back(); };
+
+	pending_chunk& current_chunk() { return top() == frame::chunk ? pending_layers.back().chunks.back() : pending_layers.back().whole; };
+
+	bool null() { return true; };
+	bool boolean(bool value)
+	{
+		if (top() == frame::root && current_key == "infinite")
+			infinite = value;
+		return true;
+	};
+	bool number_integer(json::number_integer_t value)
+	{
+		switch (top())
+		{
+		case frame::data:
+			if (value < 0)
+				crash("Invalid tile id");
+			data_target->push_back(static_cast<uint32_t>(value) & tile_id_mask);
+			break;
+		case frame::root:
+			if (value < 0)
+				break;
+			if (current_key == "width") { width = static_cast<unsigned int>(value); has_width = true; }
+			else if (current_key == "height") { height = static_cast<unsigned int>(value); has_height = true; }
+			break;
+		case frame::layer:
+		case frame::chunk:
+		{
+			auto& c = current_chunk().chunk;
+			if (current_key == "x") c.x = static_cast<int>(value);
+			else if (current_key == "y") c.y = static_cast<int>(value);
+			else if (current_key == "width" && value >= 0) c.width = static_cast<unsigned int>(value);
+			else if (current_key == "height" && value >= 0) c.height = static_cast<unsigned int>(value);
+			break;
+		}
+		default:
+			break;
+		}
+		return true;
+	};
+	bool number_unsigned(json::number_unsigned_t value)
+	{
+		if (top() == frame::data)
+		{
+			data_target->push_back(static_cast<uint32_t>(value) & tile_id_mask);
+			return true;
+		}
+		return number_integer(static_cast<json::number_integer_t>(value & INT_MAX));
+	};
+	bool number_float(json::number_float_t, const json::string_t&)
+	{
+		if (top() == frame::data)
+			crash("Invalid tile id");
+		return true;
+	};
+	bool string(json::string_t& value)
+	{
+		if (top() == frame::chunk && current_key == "data")
+		{
+			current_chunk().encoded = std::move(value);
+			current_chunk().has_data = true;
+		}
+		else if (top() == frame::layer)
+		{
+			auto& layer = pending_layers.back();
+			if (current_key == "data")
+			{
+				layer.whole.encoded = std::move(value);
+				layer.whole.has_data = true;
+			}
+			else if (current_key == "encoding")
+				layer.encoding = value;
+			else if (current_key == "compression")
+				layer.compression = value;
+		}
+		return true;
+	};
+	bool binary(json::binary_t&) { return true; };
+
+	bool start_object(std::size_t)
+	{
+		switch (top())
+		{
+		case frame::layers:
+			frames.push_back(frame::layer);
+			pending_layers.push_back({});
+			break;
+		case frame::chunks:
+			frames.push_back(frame::chunk);
+			pending_layers.back().chunks.push_back({});
+			break;
+		default:
+			frames.push_back(frames.empty() ? frame::root : frame::skipped);
+			break;
+		}
+		return true;
+	};
+	bool key(json::string_t& value)
+	{
+		current_key = std::move(value);
+		return true;
+	};
+	bool end_object()
+	{
+		if (top() == frame::layer)
+			finish_layer();
+		frames.pop_back();
+		return true;
+	};
+	bool start_array(std::size_t)
+	{
+		frame current = top();
+		if (current_key == "layers" && (current == frame::root || current == frame::layer))
+		{
+			has_layers |= current == frame::root;
+			frames.push_back(frame::layers);
+		}
+		else if (current_key == "chunks" && current == frame::layer)
+			frames.push_back(frame::chunks);
+		else if (current_key == "data" && (current == frame::layer || current == frame::chunk))
+		{
+			auto& c = current_chunk();
+			c.has_data = true;
+			data_target = &c.chunk.tiles;
+			frames.push_back(frame::data);
+		}
+		else
+			frames.push_back(frame::skipped);
+		return true;
+	};
+	bool end_array()
+	{
+		frames.pop_back();
+		return true;
+	};
+	bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& exception)
+	{
+		crash("Invalid source file at " + std::to_string(position) + ": " + exception.what());
+		return false;
+	};
+
+	//layers without tiles (objects, images, groups) are ignored, group children are added in order
+	void finish_layer()
+	{
+		auto& pending = pending_layers.back();
+		assets::tilemap::layer layer;
+
+		auto finish_chunk = [&](pending_chunk& c)
+		{
+			size_t tiles_amount = size_t(c.chunk.width) * c.chunk.height;
+			if (!c.encoded.empty())
+				c.chunk.tiles = decode_tiles(c.encoded, pending.encoding, pending.compression, tiles_amount);
+			layer.chunks.push_back(std::move(c.chunk));
+		};
+
+		if (!pending.chunks.empty())
+			for (auto& c : pending.chunks)
+				finish_chunk(c);
+		else if (pending.whole.has_data)
+		{
+			//finite layers always start at 0, 0
+			pending.whole.chunk.x = 0;
+			pending.whole.chunk.y = 0;
+			finish_chunk(pending.whole);
+		}
+
+		if (!layer.chunks.empty())
+			layers.push_back(std::move(layer));
+		pending_layers.pop_back();
+	}
+};
+
+namespace assets
+{
+	namespace loading
+	{
+		std::shared_ptr<asset> load_tilemap(const load_data& ld)
+		{
+			auto& header = *ld.header_data;
+
+			if (!(header.contains("path") && header.at("path").is_string()))
+				crash("Invalid/Missing path");
+
+			std::string file_path = create_path(header.at("path"), ld.package);
+			std::string source = filesystem::load_file_data(file_path);
+
+			tilemap_sax sax;
+			nlohmann::json::sax_parse(source, &sax);
+			source = {};
+
+			if (!sax.has_width)
+				crash("Source file is missing width");
+			if (!sax.has_height)
+				crash("Source file is missing height");
+			if (!sax.has_layers)
+				crash("Source file is missing layers");
+
+			int origin_x = 0, origin_y = 0;
+			unsigned int width = sax.width, height = sax.height;
+
+			if (sax.infinite && !sax.layers.empty())
+			{
+				int min_x = INT_MAX, min_y = INT_MAX, max_x = INT_MIN, max_y = INT_MIN;
+				for (auto& layer : sax.layers)
+					for (auto& c : layer.chunks)
+					{
+						min_x = std::min(min_x, c.x);
+						min_y = std::min(min_y, c.y);
+						max_x = std::max(max_x, c.x + static_cast<int>(c.width));
+						max_y = std::max(max_y, c.y + static_cast<int>(c.height));
+					}
+				origin_x = min_x;
+				origin_y = min_y;
+				width = static_cast<unsigned int>(max_x - min_x);
+				height = static_cast<unsigned int>(max_y - min_y);
+			}
+
+			for (auto& layer : sax.layers)
+				for (auto& c : layer.chunks)
+				{
+					if (!sax.infinite)
+					{
+						c.width = width;
+						c.height = height;
+					}
+					if (c.tiles.size() != size_t(c.width) * c.height)
+						crash("Invalid layer");
+				}
+
+			std::shared_ptr<asset> tilemap_asset
+				= std::make_shared<assets::tilemap>(width, height, origin_x, origin_y, sax.infinite, std::move(sax.layers));
+			return tilemap_asset;
+		}
+	}
+}
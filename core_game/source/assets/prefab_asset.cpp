@@ -0,0 +1,29 @@
+#include "prefab_asset.h"
+#include "assets_manager.h"
+#include "collision_config_asset.h"
+
+#include "source/common/common.h"
+#include "source/utilities/hash_string.h"
+
+void assets::prefab::resolve()
+{
+	auto config = cast_asset<collision_config>(common::assets_manager->get_asset(utilities::hash_string("mod/collision_config"))).lock();
+
+	for (auto& c : components)
+	{
+		if (!c.asset_path.empty() && c.resolved_asset.expired())
+			c.resolved_asset = common::assets_manager->safe_get_asset(c.asset_path);
+		if (c.preset_name != 0)
+			c.preset = config->get_preset(c.preset_name);
+	}
+}
+
+bool assets::prefab::hot_swap(asset& fresh)
+{
+	auto other = dynamic_cast<prefab*>(&fresh);
+	if (other == nullptr)
+		return false;
+	std::swap(layer, other->layer);
+	std::swap(components, other->components);
+	return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "asset.h"
+#include "source/entities/component.h"
+#include "source/physics/collision.h"
+
+#include "include/glm/vec2.hpp"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+namespace assets
+{
+	/*
+		prefab
+		set of components instantiated together by _en_spawn_prefab
+		asset paths and collision presets of the components are resolved on every spawn call,
+		so the prefab doesn't keep its assets loaded and follows the current collision config
+	*/
+	struct prefab : public asset
+	{
+		struct component
+		{
+			entities::component_type type;
+			uint32_t id;
+			//texture of sprite, flipbook of flipbook, behavior of behavior
+			std::string asset_path;
+			uint32_t preset_name = 0;
+			//hashed flipbook animation
+			uint32_t animation = 0;
+			int sprite_id = 0;
+			//collider extend
+			glm::vec2 extend = { 1, 1 };
+			//camera ortho width
+			float width = 0;
+
+			std::weak_ptr<asset> resolved_asset;
+			physics::collision_preset preset = 0;
+		};
+
+		uint8_t layer;
+		std::vector<component> components;
+
+		prefab(uint8_t _layer, std::vector<component>& _components) : layer(_layer), components(std::move(_components)) {};
+
+		/*
+			resolve
+			loads assets used by the components which were unloaded since the last call
+			and looks up their collision presets
+		*/
+		void resolve();
+
+		virtual bool hot_swap(asset& fresh) override;
+	};
+}
@@ -10,4 +10,13 @@ assets::scene::scene(std::string& lua_file_path)
 assets::scene::~scene()
 {
     common::behaviors_manager->destroy_functions_table(name);
+}
+
+bool assets::scene::hot_swap(asset& fresh)
+{
+    auto other = dynamic_cast<scene*>(&fresh);
+    if (other == nullptr)
+        return false;
+    std::swap(name, other->name);
+    return true;
 }
\ No newline at end of file
@@ -16,5 +16,6 @@ namespace assets
 	public:
 		scene(std::string& lua_file_path);
 		~scene();
+		virtual bool hot_swap(asset& fresh) override;
 	};
 }
\ No newline at end of file
@@ -58,4 +58,14 @@ namespace assets
 		common::renderer->get_api()->free(_shader);
 		common::renderer->get_api()->free(vertex_layout);
 	}
+
+	bool shader::hot_swap(asset& fresh)
+	{
+		auto other = dynamic_cast<shader*>(&fresh);
+		if (other == nullptr)
+			return false;
+		std::swap(_shader, other->_shader);
+		std::swap(vertex_layout, other->vertex_layout);
+		return true;
+	}
 }
\ No newline at end of file
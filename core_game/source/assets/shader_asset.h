@@ -31,5 +31,6 @@ namespace assets
 		shader(std::string& vertex_shader, std::string& pixel_shader,
 			std::vector<uint32_t>& hashed_layout);
 		~shader();
+		virtual bool hot_swap(asset& fresh) override;
 	};
 }
\ No newline at end of file
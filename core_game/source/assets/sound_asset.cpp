@@ -3,7 +3,7 @@
 #include "source/filesystem/filesystem.h"
 
 assets::sound::sound(std::string _file_path)
-	: file_path(filesystem::get_global_path(std::move(_file_path)))
+	: file_path(filesystem::resolve_path(std::move(_file_path)))
 {
 }
 
@@ -1,13 +1,26 @@
 #include "sprite_sheet.h"
 
+#include <typeinfo>
+
 namespace assets
 {
-	sprite_sheet::sprite_sheet(filesystem::image_file* data, unsigned int _sprite_width, unsigned int _sprite_height)
-		: texture(data), sprite_width(_sprite_width), sprite_height(_sprite_height)
+	sprite_sheet::sprite_sheet(filesystem::image_file* data, unsigned int _sprite_width, unsigned int _sprite_height,
+		graphics_abstraction::buffer* pixel_buffer)
+		: texture(data, pixel_buffer), sprite_width(_sprite_width), sprite_height(_sprite_height)
 	{
 	}
 
 	sprite_sheet::~sprite_sheet()
 	{
 	}
+
+	bool sprite_sheet::hot_swap(asset& fresh)
+	{
+		if (typeid(fresh) != typeid(*this))
+			return false;
+		auto& other = static_cast<sprite_sheet&>(fresh);
+		if (other.sprite_width != sprite_width || other.sprite_height != sprite_height)
+			return false;
+		return texture::hot_swap(fresh);
+	}
 }
\ No newline at end of file
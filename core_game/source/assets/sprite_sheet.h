@@ -8,7 +8,13 @@ namespace assets
 	public:
 		const unsigned int sprite_width;
 		const unsigned int sprite_height;
-		sprite_sheet(filesystem::image_file* data, unsigned int _sprite_width, unsigned int _sprite_height);
+		sprite_sheet(filesystem::image_file* data, unsigned int _sprite_width, unsigned int _sprite_height,
+			graphics_abstraction::buffer* pixel_buffer = nullptr);
 		~sprite_sheet();
+		/*
+			hot_swap
+			swaps only the image, sprite sizes are const so a changed size requires reloading the mod
+		*/
+		virtual bool hot_swap(asset& fresh) override;
 	};
 }
\ No newline at end of file
@@ -3,10 +3,13 @@
 #include "source/filesystem/filesystem.h"
 #include "source/rendering/renderer.h"
 #include "graphics_abstraction/graphics_abstraction.h"
+#include <typeinfo>
+#include <cstring>
+#include <algorithm>
 
 namespace assets
 {
-	texture::texture(filesystem::image_file* data)
+	texture::texture(filesystem::image_file* data, graphics_abstraction::buffer* pixel_buffer)
 	{
 		auto api = common::renderer->get_api();
 		auto tb = api->create_texture_builder();
@@ -24,7 +27,33 @@ namespace assets
 		tb->width = data->width;
 		tb->height = data->height;
 		tb->source_data_type = graphics_abstraction::input_data_type::unsigned_byte;
-		tb->source_texture = data->image_source_pointer;
+
+		size_t row_size = static_cast<size_t>(data->width) * data->color_channels;
+		auto row = [&](int y) { return data->image_source_pointer + row_size * y; };
+
+		if (pixel_buffer != nullptr)
+		{
+			//orphan the previous storage, then copy rows flipping them if needed
+			pixel_buffer->reallocate(static_cast<uint32_t>(row_size * data->height));
+			auto destination = static_cast<unsigned char*>(pixel_buffer->open_data_stream());
+			for (int y = 0; y < data->height; y++)
+				std::memcpy(destination + row_size * y, 
+					row(data->bottom_to_top ? y : data->height - 1 - y), row_size);
+			pixel_buffer->close_data_stream();
+
+			tb->source_buffer = pixel_buffer;
+			tb->source_texture = nullptr;
+		}
+		else
+		{
+			if (!data->bottom_to_top)
+			{
+				for (int y = 0; y < data->height / 2; y++)
+					std::swap_ranges(row(y), row(y) + row_size, row(data->height - 1 - y));
+				data->bottom_to_top = true;
+			}
+			tb->source_texture = data->image_source_pointer;
+		}
 		tb->mag_filter = graphics_abstraction::texture_filtering::nearest;
 		tb->min_filter = graphics_abstraction::texture_filtering::nearest;
 		_texture = reinterpret_cast<graphics_abstraction::texture*>(api->build(tb));
@@ -35,6 +64,14 @@ namespace assets
 		common::renderer->get_api()->free(_texture);
 	}
 
+	bool texture::hot_swap(asset& fresh)
+	{
+		if (typeid(fresh) != typeid(*this))
+			return false;
+		std::swap(_texture, static_cast<texture&>(fresh)._texture);
+		return true;
+	}
+
 	unsigned int texture::get_width()
 	{
 		return _texture->width;
@@ -9,6 +9,7 @@ namespace rendering
 namespace graphics_abstraction
 {
 	struct texture;
+	struct buffer;
 }
 
 namespace filesystem
@@ -24,8 +25,16 @@ namespace assets
 	protected:
 		graphics_abstraction::texture* _texture;
 	public:
-		texture(filesystem::image_file* data);
+		/*
+			texture
+			-l-
+			[data] image to upload
+			[pixel_buffer] optional pixel_unpack buffer used for the upload, 
+				it is reallocated, so the upload does not wait for the previous one
+		*/
+		texture(filesystem::image_file* data, graphics_abstraction::buffer* pixel_buffer = nullptr);
 		~texture();
+		virtual bool hot_swap(asset& fresh) override;
 		unsigned int get_width();
 		unsigned int get_height();
 	};
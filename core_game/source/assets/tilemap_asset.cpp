@@ -1,11 +1,46 @@
 #include "tilemap_asset.h"
 
+#include "source/common/crash.h"
+#include "source/filesystem/lz4.h"
+
 namespace assets
 {
-	tilemap::tilemap(unsigned int _width, unsigned int _height, std::vector<layer>& _tiles)
-		: width(_width), height(_height), layers(_tiles)
+	tilemap::tilemap(unsigned int _width, unsigned int _height, int _origin_x, int _origin_y, bool _infinite, std::vector<layer>&& _layers)
+		: width(_width), height(_height), origin_x(_origin_x), origin_y(_origin_y), infinite(_infinite), layers(std::move(_layers))
 	{
+		if (!infinite)
+			return;
+
+		for (auto& layer : layers)
+			for (auto& c : layer.chunks)
+			{
+				c.packed = filesystem::lz4::compress(
+					reinterpret_cast<const char*>(c.tiles.data()), c.tiles.size() * sizeof(uint32_t));
+				c.tiles = {};
+			}
 	}
 
 	tilemap::~tilemap() {};
-}
\ No newline at end of file
+
+	void tilemap::acquire_chunk(chunk& c)
+	{
+		c.users++;
+		if (c.is_resident() || c.packed.empty())
+			return;
+
+		c.tiles.resize(size_t(c.width) * c.height);
+		if (!filesystem::lz4::decompress(c.packed.data(), c.packed.size(),
+			reinterpret_cast<char*>(c.tiles.data()), c.tiles.size() * sizeof(uint32_t)))
+			error_handling::crash(error_handling::error_source::core, "[tilemap::acquire_chunk]",
+				"Corrupted tilemap chunk");
+	}
+
+	void tilemap::release_chunk(chunk& c)
+	{
+		if (c.users == 0)
+			return;
+		c.users--;
+		if (c.users == 0 && !c.packed.empty())
+			c.tiles = {};
+	}
+}
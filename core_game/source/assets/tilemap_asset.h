@@ -1,21 +1,64 @@
 #pragma once
 #include "texture_asset.h"
 #include <vector>
+#include <string>
+#include <cstdint>
 
 namespace assets
 {
 	struct tilemap : public asset
 	{
 	public:
+		/*
+			chunk
+			rectangular part of the layer
+			tiles are stored row by row, from the top one (as in tiled), 0 is an empty tile
+		*/
+		struct chunk
+		{
+			//position of the top left tile in tiles, y grows downwards
+			int x = 0;
+			int y = 0;
+			unsigned int width = 0;
+			unsigned int height = 0;
+			//empty if the chunk isn't resident
+			std::vector<uint32_t> tiles;
+			//lz4 packed tiles of the streamed chunk, empty if the chunk is always resident
+			std::string packed;
+			//number of acquire_chunk calls without release_chunk
+			unsigned int users = 0;
+
+			bool is_resident() const { return !tiles.empty(); };
+		};
+
+		struct layer
+		{
+			std::vector<chunk> chunks;
+		};
+
+		//size of the area covered by the chunks, in tiles
 		const unsigned int width;
 		const unsigned int height;
+		//position of the top left tile of the area, 0, 0 for finite maps
+		const int origin_x;
+		const int origin_y;
+		//infinite maps keep only the acquired chunks resident
+		const bool infinite;
 
-		using row = std::vector<int>;
-		using layer = std::vector<row>;
+		std::vector<layer> layers;
 
-		const std::vector<layer> layers;
-
-		tilemap(unsigned int _width, unsigned int _height, std::vector<layer>& _tiles);
+		tilemap(unsigned int _width, unsigned int _height, int _origin_x, int _origin_y, bool _infinite, std::vector<layer>&& _layers);
 		~tilemap();
+
+		/*
+			acquire_chunk
+			makes chunk tiles resident until the matching release_chunk
+		*/
+		void acquire_chunk(chunk& c);
+		/*
+			release_chunk
+			drops chunk tiles when no one uses them anymore, finite maps chunks are never dropped
+		*/
+		void release_chunk(chunk& c);
 	};
-}
\ No newline at end of file
+}
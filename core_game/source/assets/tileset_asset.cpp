@@ -1,15 +1,28 @@
 #include "tileset_asset.h"
 
+#include <typeinfo>
+
 namespace assets
 {
 	tileset::tileset(filesystem::image_file* data,
 		unsigned int _tile_width, unsigned int _tile_height,
-		std::vector<int> _colliding_tiles)
-		: texture(data), tile_width(_tile_width), tile_height(_tile_height), colliding_tiles(_colliding_tiles)
+		std::vector<int> _colliding_tiles,
+		graphics_abstraction::buffer* pixel_buffer)
+		: texture(data, pixel_buffer), tile_width(_tile_width), tile_height(_tile_height), colliding_tiles(_colliding_tiles)
 	{
 	}
 
 	tileset::~tileset()
 	{
 	}
+
+	bool tileset::hot_swap(asset& fresh)
+	{
+		if (typeid(fresh) != typeid(*this))
+			return false;
+		auto& other = static_cast<tileset&>(fresh);
+		if (other.tile_width != tile_width || other.tile_height != tile_height || other.colliding_tiles != colliding_tiles)
+			return false;
+		return texture::hot_swap(fresh);
+	}
 }
\ No newline at end of file
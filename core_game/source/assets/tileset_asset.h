@@ -17,7 +17,13 @@ namespace assets
 		const std::vector<int> colliding_tiles;
 		tileset(filesystem::image_file* data, 
 			unsigned int _tile_width, unsigned int _tile_height,
-			std::vector<int> _colliding_tiles);
+			std::vector<int> _colliding_tiles,
+			graphics_abstraction::buffer* pixel_buffer = nullptr);
 		~tileset();
+		/*
+			hot_swap
+			swaps only the image, changed tile sizes or colliding tiles require reloading the mod
+		*/
+		virtual bool hot_swap(asset& fresh) override;
 	};
 }
\ No newline at end of file
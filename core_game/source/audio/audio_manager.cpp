@@ -3,6 +3,7 @@
 #include "source/common/common.h"
 #include "source/common/crash.h"
 #include "source/filesystem/filesystem.h"
+#include "source/filesystem/mounts.h"
 
 #include "source/entities/entity.h"
 #include "source/components/listener.h"
@@ -12,6 +13,7 @@
 
 #include <list>
 #include <unordered_map>
+#include <cstring>
 
 using namespace audio;
 
@@ -51,8 +53,108 @@ bool operator==(std::pair<sound_emitter*, emitter_sounds> a, sound_emitter* b)
     return a.first == b;
 }
 
+/*
+    mounts_vfs
+    lets miniaudio read sounds from the mounted directories and packs
+    sounds paths are resolved paths, see filesystem::resolve_path
+*/
+struct mounts_vfs
+{
+    ma_vfs_callbacks callbacks;
+
+    struct file
+    {
+        std::string data;
+        size_t cursor = 0;
+    };
+
+    static ma_result on_open(ma_vfs* vfs, const char* path, ma_uint32 open_mode, ma_vfs_file* result)
+    {
+        if (open_mode & MA_OPEN_MODE_WRITE)
+            return MA_ACCESS_DENIED;
+
+        auto f = new file;
+        if (!filesystem::read_mounted_file(path, f->data))
+        {
+            delete f;
+            return MA_DOES_NOT_EXIST;
+        }
+        *result = f;
+        return MA_SUCCESS;
+    }
+
+    static ma_result on_open_w(ma_vfs* vfs, const wchar_t* path, ma_uint32 open_mode, ma_vfs_file* result)
+    {
+        return MA_NOT_IMPLEMENTED;
+    }
+
+    static ma_result on_close(ma_vfs* vfs, ma_vfs_file handle)
+    {
+        delete static_cast<file*>(handle);
+        return MA_SUCCESS;
+    }
+
+    static ma_result on_read(ma_vfs* vfs, ma_vfs_file handle, void* destination, size_t size, size_t* bytes_read)
+    {
+        auto f = static_cast<file*>(handle);
+        size_t count = std::min(size, f->data.size() - f->cursor);
+        std::memcpy(destination, f->data.data() + f->cursor, count);
+        f->cursor += count;
+        if (bytes_read != nullptr)
+            *bytes_read = count;
+        return (count == 0 && size != 0) ? MA_AT_END : MA_SUCCESS;
+    }
+
+    static ma_result on_write(ma_vfs* vfs, ma_vfs_file handle, const void* source, size_t size, size_t* bytes_written)
+    {
+        return MA_ACCESS_DENIED;
+    }
+
+    static ma_result on_seek(ma_vfs* vfs, ma_vfs_file handle, ma_int64 offset, ma_seek_origin origin)
+    {
+        auto f = static_cast<file*>(handle);
+        ma_int64 base = 0;
+        if (origin == ma_seek_origin_current)
+            base = static_cast<ma_int64>(f->cursor);
+        else if (origin == ma_seek_origin_end)
+            base = static_cast<ma_int64>(f->data.size());
+
+        ma_int64 position = base + offset;
+        if (position < 0 || position > static_cast<ma_int64>(f->data.size()))
+            return MA_BAD_SEEK;
+        f->cursor = static_cast<size_t>(position);
+        return MA_SUCCESS;
+    }
+
+    static ma_result on_tell(ma_vfs* vfs, ma_vfs_file handle, ma_int64* cursor)
+    {
+        *cursor = static_cast<ma_int64>(static_cast<file*>(handle)->cursor);
+        return MA_SUCCESS;
+    }
+
+    static ma_result on_info(ma_vfs* vfs, ma_vfs_file handle, ma_file_info* info)
+    {
+        info->sizeInBytes = static_cast<ma_uint64>(static_cast<file*>(handle)->data.size());
+        return MA_SUCCESS;
+    }
+
+    mounts_vfs()
+    {
+        callbacks.onOpen = on_open;
+        callbacks.onOpenW = on_open_w;
+        callbacks.onClose = on_close;
+        callbacks.onRead = on_read;
+        callbacks.onWrite = on_write;
+        callbacks.onSeek = on_seek;
+        callbacks.onTell = on_tell;
+        callbacks.onInfo = on_info;
+    }
+};
+
 struct audio_manager::implementation
 {
+    //has to outlive the engine
+    mounts_vfs vfs;
     ma_engine engine;
     ma_device device;
     ma_sound_group group;
@@ -84,6 +186,7 @@ audio_manager::audio_manager()
 
     auto engineConfig = ma_engine_config_init();
     engineConfig.listenerCount = 1;
+    engineConfig.pResourceManagerVFS = &impl->vfs;
 
     result = ma_engine_init(&engineConfig, &impl->engine);
     if (result != MA_SUCCESS)
@@ -127,7 +230,7 @@ void audio_manager::update()
 
     ma_sound_group_set_volume(&impl->group, impl->desired_volume);
 
-    auto e = impl->active_listener->get_owner_weak().lock();
+    auto e = impl->active_listener->get_owner();
 
     ma_engine_listener_set_position(
         &impl->engine, 
@@ -139,7 +242,7 @@ void audio_manager::update()
 
     for (auto& emitter : impl->emitters)
     {
-        auto owner = emitter.first->get_owner_weak().lock();
+        auto owner = emitter.first->get_owner();
 
         auto& sounds = emitter.second.sounds;
 
@@ -281,7 +384,7 @@ void audio_manager::emit_sound(sound_emitter* emitter, std::weak_ptr<assets::sou
             "Cannot play file: " + sound.lock()->file_path + " Error code: " + std::to_string(result));
     }
 
-    auto owner = emitter->get_owner_weak().lock();
+    auto owner = emitter->get_owner();
 
     ma_sound_set_position(
         ptr,
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 
 namespace behaviors
 {
@@ -6,5 +8,28 @@ namespace behaviors
 	{
 		init, update, destroy,
 		on_overlap, on_collide,
+		update_batch,
 	};
-}
\ No newline at end of file
+
+	constexpr size_t functions_count = 6;
+
+	/*
+		function_refs
+		lua registry references of the behavior functions, resolved once when behavior is loaded
+	*/
+	struct function_refs
+	{
+		//indexed with functions, negative if function is not implemented
+		int refs[functions_count] = { -1, -1, -1, -1, -1, -1 };
+		//tables passed to on_update_batch, reused every frame, negative if update_batch is not implemented
+		int batch_entities = -1;
+		int batch_selves = -1;
+		//amount of elements in the batch tables
+		uint32_t batch_size = 0;
+		//generation of the lua state refs belong to, refs of a closed state are not released
+		uint64_t state_generation = 0;
+
+		bool implements(functions func) const { return refs[static_cast<size_t>(func)] >= 0; };
+		int get(functions func) const { return refs[static_cast<size_t>(func)]; };
+	};
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+namespace behaviors
+{
+	/*
+		behavior_stats
+		execution cost of a behavior asset, summed over all its calls
+		time and instructions of nested calls are counted only for the called behaviors
+	*/
+	struct behavior_stats
+	{
+		uint64_t calls = 0;
+		//counted every hook interval, so accurate to about a thousand instructions
+		uint64_t instructions = 0;
+		double seconds = 0;
+	};
+}
@@ -11,6 +11,8 @@ extern "C"
 
 #include "source/common/common.h"
 #include "source/filesystem/filesystem.h"
+#include "source/mods/mods_manager.h"
+#include "source/utilities/hash_string.h"
 
 #include "source/assets/assets_manager.h"
 #include "source/assets/behavior_asset.h"
@@ -19,12 +21,24 @@ extern "C"
 
 #include "source/common/crash.h"
 #include "register_shared.h"
+#include "source/behaviors_shared/entity_reference.h"
 
 #include "frame.h"
+#include "timer_wheel.h"
 
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+//instructions between the count hook calls
+constexpr int hook_instructions_interval = 1000;
+//duration of a single tick of the tasks time wheel, in seconds
+constexpr double time_wheel_tick = 1.0 / 60.0;
 
 struct behaviors::behaviors_manager::implementation
 {
@@ -35,6 +49,11 @@ struct behaviors::behaviors_manager::implementation
         owned by behaviors_manager
     */
     lua_State* L = nullptr;
+    /*
+        allocator
+        allocator of L, recreated together with it
+    */
+    std::unique_ptr<lua_allocator> allocator;
     /*
         behaviors_id_iterator
         used to name behaviors inside the lua environement
@@ -43,9 +62,10 @@ struct behaviors::behaviors_manager::implementation
     /*
         registered_behaviors
         set of all behavior components in the world
-        bool indicates if behavior should not be deleted
+        each behavior keeps its index, they are removed with swap and pop
+        structural changes from lua are deferred to the command buffer, so behaviors are never removed during the update loop
     */
-    std::list<std::pair<entities::components::behavior*, bool>> registered_behaviors;
+    std::vector<entities::components::behavior*> registered_behaviors;
     /*
         frames_stack
         saves states of the program in certain points of time (function calls) so they can be restored
@@ -59,18 +79,263 @@ struct behaviors::behaviors_manager::implementation
         value is lua registry address of the module
     */
     std::unordered_map<std::string, int> loaded_modules;
+    /*
+        bytecode_cache
+        compiled chunks, kept between clear() calls
+        key is cache file name, value is cache file content (source hash + bytecode)
+    */
+    std::unordered_map<std::string, std::string> bytecode_cache;
+    /*
+        state_generation
+        incremented every time L is recreated
+    */
+    uint64_t state_generation = 0;
+    /*
+        update_batches
+        components of behaviors implementing on_update_batch, collected every frame
+        components are kept by the owner handle and id, so a batch callback destroying components of later batches is safe
+        batches_order keeps assets in order of the first registered component
+    */
+    struct batch_entry
+    {
+        entities::entity_handle owner;
+        uint32_t id;
+    };
+    std::unordered_map<assets::behavior*, std::vector<batch_entry>> update_batches;
+    std::vector<assets::behavior*> batches_order;
+    /*
+        profiled_calls
+        stack of the calls being executed, used to measure time and instructions of each behavior
+        stats are nullptr for calls that aren't made on behavior (eg. scenes)
+    */
+    struct profiled_call
+    {
+        behavior_stats* stats;
+        std::chrono::steady_clock::time_point segment_start;
+        uint64_t instructions;
+    };
+    std::vector<profiled_call> profiled_calls;
+    //stats of the behavior whose function was prepared for the next call
+    behavior_stats* next_call_stats = nullptr;
+    /*
+        behaviors_stats
+        key is behavior file path, so stats survive assets reloads
+    */
+    std::unordered_map<std::string, std::shared_ptr<behavior_stats>> behaviors_stats;
+    //in seconds, 0 if disabled
+    double frame_budget = 0;
+    //0 if disabled
+    uint64_t instructions_limit = 0;
+
+    /*
+        tasks
+        coroutines started with start_task, key is task id
+    */
+    struct task
+    {
+        int thread_ref;
+        lua_State* thread;
+        //tasks started outside of behaviors have no database
+        bool has_database;
+        std::weak_ptr<database> database;
+        entities::scene* scene;
+        behavior_stats* stats;
+        //arguments waiting for the first resume
+        int arguments;
+        bool waiting = false;
+        bool running = false;
+        bool cancelled = false;
+        //signal the task waits for, empty if it doesn't
+        std::string signal;
+    };
+    std::unordered_map<uint64_t, task> tasks;
+    uint64_t tasks_id_iterator = 0;
+    //0 if no task is running
+    uint64_t current_task = 0;
+    timer_wheel time_wheel;
+    timer_wheel frames_wheel;
+    double time_wheel_accumulator = 0;
+    std::unordered_map<std::string, std::vector<uint64_t>> signal_waiting_tasks;
+    std::vector<uint64_t> signaled_tasks;
+
+    int load_chunk(const std::string& path);
+    void create_state();
+    void bind_self();
+    void destroy_task(uint64_t id);
+    void begin_profiled_call();
+    void end_profiled_call();
+    static void count_hook(lua_State* L, lua_Debug* ar);
+    static int panic(lua_State* L);
 };
 
+/*
+    create_state
+    creates lua state with the engine api and the instructions count hook
+*/
+void behaviors::behaviors_manager::implementation::create_state()
+{
+    allocator = std::make_unique<lua_allocator>();
+    L = lua_newstate(lua_allocator::allocate, allocator.get());
+    if (L == nullptr)
+        error_handling::crash(error_handling::error_source::core, "[behaviors_manager::create_state]",
+            "Unable to create lua state");
+    lua_atpanic(L, panic);
+    luaL_openlibs(L);
+    behaviors::register_shared(L);
+    *static_cast<implementation**>(lua_getextraspace(L)) = this;
+    lua_sethook(L, count_hook, LUA_MASKCOUNT, hook_instructions_interval);
+}
+
+/*
+    bind_self
+    sets self global to the database of the current frame
+*/
+void behaviors::behaviors_manager::implementation::bind_self()
+{
+    if (frames_stack.size() == 0 || frames_stack.back().target_object_database == nullptr)
+        lua_pushnil(L);
+    else
+        lua_rawgeti(L, LUA_REGISTRYINDEX, frames_stack.back().target_object_database->table_ref);
+    lua_setglobal(L, "self");
+}
+
+void behaviors::behaviors_manager::implementation::destroy_task(uint64_t id)
+{
+    auto itr = tasks.find(id);
+    if (itr == tasks.end())
+        return;
+
+    //signals which never fire would keep ids of destroyed tasks until the mod is unloaded
+    if (!itr->second.signal.empty())
+    {
+        auto waiting = signal_waiting_tasks.find(itr->second.signal);
+        if (waiting != signal_waiting_tasks.end())
+        {
+            auto& ids = waiting->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+            if (ids.empty())
+                signal_waiting_tasks.erase(waiting);
+        }
+    }
+
+    luaL_unref(L, LUA_REGISTRYINDEX, itr->second.thread_ref);
+    tasks.erase(itr);
+}
+
+int behaviors::behaviors_manager::implementation::panic(lua_State* L)
+{
+    const char* message = lua_tostring(L, -1);
+    error_handling::crash(error_handling::error_source::core, "[behaviors_manager::panic]",
+        std::string("Unprotected lua error: ") + (message != nullptr ? message : "unknown error"));
+    return 0;
+}
+
+void behaviors::behaviors_manager::implementation::count_hook(lua_State* L, lua_Debug* ar)
+{
+    auto self = *static_cast<implementation**>(lua_getextraspace(L));
+    if (self->profiled_calls.empty())
+        return;
+
+    auto& call = self->profiled_calls.back();
+    call.instructions += hook_instructions_interval;
+    if (call.stats != nullptr)
+        call.stats->instructions += hook_instructions_interval;
+
+    if (self->instructions_limit != 0 && call.instructions > self->instructions_limit)
+        luaL_error(L, "Instructions limit (%llu) exceeded, the function probably never ends",
+            static_cast<unsigned long long>(self->instructions_limit));
+}
+
+void behaviors::behaviors_manager::implementation::begin_profiled_call()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (!profiled_calls.empty() && profiled_calls.back().stats != nullptr)
+        profiled_calls.back().stats->seconds += std::chrono::duration<double>(now - profiled_calls.back().segment_start).count();
+
+    profiled_calls.push_back({ next_call_stats, now, 0 });
+    if (next_call_stats != nullptr)
+        next_call_stats->calls++;
+    next_call_stats = nullptr;
+}
+
+void behaviors::behaviors_manager::implementation::end_profiled_call()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (profiled_calls.back().stats != nullptr)
+        profiled_calls.back().stats->seconds += std::chrono::duration<double>(now - profiled_calls.back().segment_start).count();
+
+    profiled_calls.pop_back();
+    if (!profiled_calls.empty())
+        profiled_calls.back().segment_start = now;
+}
+
+static int write_bytecode(lua_State* L, const void* data, size_t size, void* output)
+{
+    static_cast<std::string*>(output)->append(static_cast<const char*>(data), size);
+    return 0;
+}
+
+/*
+    load_chunk
+    loads lua file as a function on the top of the stack, like luaL_loadfile
+    compiled bytecode is cached in memory and in the saved directory, 
+    keyed by the mod and the file path, and validated with the source hash
+    returns lua error code
+*/
+int behaviors::behaviors_manager::implementation::load_chunk(const std::string& path)
+{
+    std::string source = filesystem::load_file_data(path);
+    std::string chunk_name = "@" + path;
+    uint64_t source_hash = utilities::hash_data(source.data(), source.size());
+
+    std::string key = common::mods_manager->get_current_mod_name() + ':' + filesystem::resolve_path(path);
+    char cache_name[32];
+    snprintf(cache_name, sizeof(cache_name), "bytecode/%016llx.luac", 
+        static_cast<unsigned long long>(utilities::hash_data(key.data(), key.size())));
+
+    auto cached = bytecode_cache.find(cache_name);
+    if (cached == bytecode_cache.end())
+    {
+        std::string data;
+        if (filesystem::load_cache_file(cache_name, data))
+            cached = bytecode_cache.insert({ cache_name, std::move(data) }).first;
+    }
+
+    if (cached != bytecode_cache.end() && cached->second.size() > sizeof(uint64_t))
+    {
+        uint64_t cached_hash;
+        std::memcpy(&cached_hash, cached->second.data(), sizeof(uint64_t));
+        if (cached_hash == source_hash)
+        {
+            if (luaL_loadbufferx(L, cached->second.data() + sizeof(uint64_t), cached->second.size() - sizeof(uint64_t),
+                chunk_name.c_str(), "b") == LUA_OK)
+                return LUA_OK;
+            //bytecode from another lua version, compile it again
+            lua_pop(L, 1);
+        }
+    }
+
+    int error = luaL_loadbuffer(L, source.data(), source.size(), chunk_name.c_str());
+    if (error != LUA_OK)
+        return error;
+
+    std::string data(sizeof(uint64_t), '\0');
+    std::memcpy(&data[0], &source_hash, sizeof(uint64_t));
+    if (lua_dump(L, write_bytecode, &data, 0) == 0)
+    {
+        filesystem::save_cache_file(cache_name, data);
+        bytecode_cache[cache_name] = std::move(data);
+    }
+    return LUA_OK;
+}
+
 /*
     allocate implementation and lua_State
 */
 behaviors::behaviors_manager::behaviors_manager()
 {
     impl = new implementation;
-    lua_State* L = luaL_newstate();
-    luaL_openlibs(L);
-    behaviors::register_shared(L);
-    impl->L = L;
+    impl->create_state();
 }
 
 /*
@@ -99,20 +364,16 @@ void behaviors::behaviors_manager::destroy_database(int id)
 
 void behaviors::behaviors_manager::register_behavior_component(entities::components::behavior* comp)
 {
-    impl->registered_behaviors.push_back({ comp, true });
+    comp->manager_index = impl->registered_behaviors.size();
+    impl->registered_behaviors.push_back(comp);
 }
 
 void behaviors::behaviors_manager::unregister_behavior_component(entities::components::behavior* comp)
 {
-    auto i = std::find(
-        impl->registered_behaviors.begin(),
-        impl->registered_behaviors.end(),
-        std::pair<entities::components::behavior*, bool>{ comp, true }
-    );
-
-    if (impl->registered_behaviors.end() == i) return;
-
-    i->second = false;
+    auto& behaviors = impl->registered_behaviors;
+    behaviors[comp->manager_index] = behaviors.back();
+    behaviors[comp->manager_index]->manager_index = comp->manager_index;
+    behaviors.pop_back();
 }
 
 void behaviors::behaviors_manager::require_module(const std::string& relative_path)
@@ -120,10 +381,10 @@ void behaviors::behaviors_manager::require_module(const std::string& relative_pa
     auto itr = impl->loaded_modules.find(relative_path);   
     if (itr == impl->loaded_modules.end())
     {
-        std::string global_path = filesystem::get_global_path(relative_path) + ".lua";
-        if (luaL_dofile(impl->L, global_path.c_str())) 
+        std::string path = relative_path + ".lua";
+        if (impl->load_chunk(path) || lua_pcall(impl->L, 0, LUA_MULTRET, 0))
         { 
-            throw std::exception{(std::string{"Unable to load lua module: " + global_path}).c_str()};
+            throw std::exception{(std::string{"Unable to load lua module: " + path}).c_str()};
         }
         int module_index = luaL_ref(impl->L, LUA_REGISTRYINDEX);
         impl->loaded_modules.insert({ relative_path, module_index });
@@ -138,32 +399,275 @@ void behaviors::behaviors_manager::clear()
         luaL_unref(impl->L, LUA_REGISTRYINDEX, module.second);
     impl->loaded_modules.clear();
     impl->frames_stack.clear();
+    impl->update_batches.clear();
+    impl->tasks.clear();
+    impl->current_task = 0;
+    impl->time_wheel.clear();
+    impl->frames_wheel.clear();
+    impl->time_wheel_accumulator = 0;
+    impl->signal_waiting_tasks.clear();
+    impl->signaled_tasks.clear();
     lua_close(impl->L);
+    impl->state_generation++;
+    impl->profiled_calls.clear();
+    impl->next_call_stats = nullptr;
 
-    lua_State* L = luaL_newstate();
-    luaL_openlibs(L);
-    behaviors::register_shared(L);
-    impl->L = L;
+    impl->create_state();
 }
 
 void behaviors::behaviors_manager::call_update_functions()
 {
-    auto itr = impl->registered_behaviors.begin();
-    while (itr != impl->registered_behaviors.end())
+    //tasks go first, so waits started during this update end in the next one at the earliest
+    update_tasks();
+
+    auto frame_start = std::chrono::steady_clock::now();
+    bool over_budget = false;
+
+    //behaviors attached during the loop are appended and updated in the same frame
+    for (size_t i = 0; i < impl->registered_behaviors.size(); i++)
     {
-        if (!itr->second)
-        { 
-            itr = impl->registered_behaviors.erase(itr);
+        auto comp = impl->registered_behaviors[i];
+        auto& refs = comp->behavior_asset->function_refs;
+        if (refs.implements(functions::update) && !refs.implements(functions::update_batch))
+        {
+            if (impl->frame_budget != 0 && !over_budget)
+                over_budget = std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_start).count() > impl->frame_budget;
+
+            if (over_budget && comp->behavior_asset->low_priority && comp->deferred_time < max_deferred_time)
+                comp->deferred_time += common::delta_time;
+            else
+                comp->call_function(functions::update);
+        }
+    }
+
+    //collected after all on_update calls, so batches contain only alive components
+    for (auto& registered : impl->registered_behaviors)
+    {
+        if (!registered->behavior_asset->function_refs.implements(functions::update_batch))
             continue;
+        auto asset = registered->behavior_asset.get();
+        auto& batch = impl->update_batches[asset];
+        if (batch.empty())
+            impl->batches_order.push_back(asset);
+        batch.push_back({ registered->get_owner_handle(), registered->id });
+    }
+
+    auto& L = impl->L;
+    for (auto& asset : impl->batches_order)
+    {
+        auto& batch = impl->update_batches.at(asset);
+        auto& refs = asset->function_refs;
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, refs.get(functions::update_batch));
+        lua_rawgeti(L, LUA_REGISTRYINDEX, refs.batch_entities);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, refs.batch_selves);
+
+        lua_Integer index = 1;
+        for (auto& entry : batch)
+        {
+            auto owner = common::entity_registry->get(entry.owner);
+            auto comp = owner != nullptr ? owner->get_component<entities::components::behavior>(entry.id) : nullptr;
+            if (comp == nullptr)
+                continue;
+            pass_entity_arg(entry.owner);
+            lua_rawseti(L, -3, index);
+            lua_rawgeti(L, LUA_REGISTRYINDEX, comp->database->table_ref);
+            lua_rawseti(L, -2, index);
+            index++;
         }
-        itr->first->call_function(functions::update);
-        if (!itr->second)
+        uint32_t passed = static_cast<uint32_t>(index - 1);
+        //trim elements left from the bigger batch
+        for (; index <= static_cast<lua_Integer>(refs.batch_size); index++)
         {
-            itr = impl->registered_behaviors.erase(itr);
-            continue;
+            lua_pushnil(L);
+            lua_rawseti(L, -3, index);
+            lua_pushnil(L);
+            lua_rawseti(L, -2, index);
+        }
+        refs.batch_size = passed;
+        batch.clear();
+
+        pass_float_arg(static_cast<float>(common::delta_time));
+        create_frame(nullptr, common::world->get_persistent_scene());
+        impl->next_call_stats = asset->stats.get();
+        call(3, 0);
+        pop_frame();
+    }
+    impl->batches_order.clear();
+}
+
+void behaviors::behaviors_manager::start_task(lua_State* L, int arguments)
+{
+    if (impl->frames_stack.empty())
+        error_handling::crash(error_handling::error_source::core, "[behaviors_manager::start_task]",
+            "Tasks can be started only during behavior or scene calls");
+    auto& frame = impl->frames_stack.back();
+
+    //thread is placed below the function, so the function with arguments can be moved to it
+    lua_State* thread = lua_newthread(L);
+    lua_insert(L, -(arguments + 2));
+    lua_xmove(L, thread, arguments + 1);
+    int thread_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    implementation::task new_task;
+    new_task.thread_ref = thread_ref;
+    new_task.thread = thread;
+    new_task.has_database = frame.target_object_database != nullptr;
+    new_task.database = frame.target_object_database;
+    new_task.scene = frame.scene_context;
+    new_task.stats = impl->profiled_calls.empty() ? nullptr : impl->profiled_calls.back().stats;
+    new_task.arguments = arguments;
+
+    uint64_t id = ++impl->tasks_id_iterator;
+    impl->tasks.insert({ id, new_task });
+    resume_task(id, L);
+}
+
+bool behaviors::behaviors_manager::is_in_task(lua_State* L)
+{
+    if (impl->current_task == 0)
+        return false;
+    return impl->tasks.at(impl->current_task).thread == L && lua_isyieldable(L);
+}
+
+void behaviors::behaviors_manager::wait_seconds(double seconds)
+{
+    impl->tasks.at(impl->current_task).waiting = true;
+    uint64_t ticks = static_cast<uint64_t>(std::ceil(std::max(seconds, 0.0) / time_wheel_tick));
+    impl->time_wheel.schedule(impl->current_task, ticks);
+}
+
+void behaviors::behaviors_manager::wait_frames(uint64_t frames)
+{
+    impl->tasks.at(impl->current_task).waiting = true;
+    impl->frames_wheel.schedule(impl->current_task, frames);
+}
+
+void behaviors::behaviors_manager::wait_signal(const std::string& signal)
+{
+    auto& task = impl->tasks.at(impl->current_task);
+    task.waiting = true;
+    task.signal = signal;
+    impl->signal_waiting_tasks[signal].push_back(impl->current_task);
+}
+
+void behaviors::behaviors_manager::signal(const std::string& signal)
+{
+    auto itr = impl->signal_waiting_tasks.find(signal);
+    if (itr == impl->signal_waiting_tasks.end())
+        return;
+    for (auto& id : itr->second)
+        impl->tasks.at(id).signal.clear();
+    impl->signaled_tasks.insert(impl->signaled_tasks.end(), itr->second.begin(), itr->second.end());
+    impl->signal_waiting_tasks.erase(itr);
+}
+
+void behaviors::behaviors_manager::cancel_scene_tasks(entities::scene* scene)
+{
+    std::vector<uint64_t> cancelled;
+    for (auto& task : impl->tasks)
+        if (task.second.scene == scene)
+        {
+            //running tasks are destroyed once they yield
+            task.second.cancelled = true;
+            if (!task.second.running)
+                cancelled.push_back(task.first);
+        }
+    for (auto& id : cancelled)
+        impl->destroy_task(id);
+}
+
+void behaviors::behaviors_manager::cancel_database_tasks(const std::shared_ptr<database>& db)
+{
+    std::vector<uint64_t> cancelled;
+    for (auto& task : impl->tasks)
+        if (task.second.has_database && task.second.database.lock() == db)
+        {
+            //running tasks are destroyed once they yield
+            task.second.cancelled = true;
+            if (!task.second.running)
+                cancelled.push_back(task.first);
+        }
+    for (auto& id : cancelled)
+        impl->destroy_task(id);
+}
+
+void behaviors::behaviors_manager::resume_task(uint64_t id, lua_State* from)
+{
+    auto itr = impl->tasks.find(id);
+    if (itr == impl->tasks.end())
+        return;
+
+    std::shared_ptr<database> task_database;
+    if (itr->second.has_database)
+    {
+        task_database = itr->second.database.lock();
+        //behavior component was destroyed while the task was sleeping
+        if (task_database == nullptr)
+        {
+            impl->destroy_task(id);
+            return;
         }
-        ++itr;
     }
+
+    create_frame(task_database, itr->second.scene);
+    impl->bind_self();
+
+    uint64_t previous_task = impl->current_task;
+    impl->current_task = id;
+    itr->second.waiting = false;
+    itr->second.running = true;
+
+    lua_State* thread = itr->second.thread;
+    int results = 0;
+    impl->next_call_stats = itr->second.stats;
+    impl->begin_profiled_call();
+    int status = lua_resume(thread, from, itr->second.arguments, &results);
+    impl->end_profiled_call();
+
+    impl->current_task = previous_task;
+    pop_frame();
+
+    //the map could be modified by the task
+    auto& task = impl->tasks.at(id);
+    task.running = false;
+    task.arguments = 0;
+
+    if (status == LUA_YIELD && !task.cancelled)
+    {
+        lua_pop(thread, results);
+        //plain coroutine.yield resumes the task in the next frame
+        if (!task.waiting)
+        {
+            task.waiting = true;
+            impl->frames_wheel.schedule(id, 1);
+        }
+        return;
+    }
+
+    if (status == LUA_ERRMEM)
+        error_handling::crash(error_handling::error_source::mod, "[behaviors_manager::resume_task]",
+            "Lua memory limit exceeded (" + std::to_string(impl->allocator->get_stats().allocated / 1024) + "KB allocated)");
+    if (status != LUA_OK && status != LUA_YIELD)
+        error_handling::crash(error_handling::error_source::core, "[behaviors_manager::resume_task]", lua_tostring(thread, -1));
+
+    impl->destroy_task(id);
+}
+
+void behaviors::behaviors_manager::update_tasks()
+{
+    std::vector<uint64_t> woken;
+    woken.swap(impl->signaled_tasks);
+
+    impl->frames_wheel.advance(1, woken);
+
+    impl->time_wheel_accumulator += common::delta_time;
+    uint64_t ticks = static_cast<uint64_t>(impl->time_wheel_accumulator / time_wheel_tick);
+    impl->time_wheel_accumulator -= ticks * time_wheel_tick;
+    impl->time_wheel.advance(ticks, woken);
+
+    for (auto& id : woken)
+        resume_task(id, impl->L);
 }
 
 std::string behaviors::behaviors_manager::create_functions_table(const std::string& file_path)
@@ -173,10 +677,8 @@ std::string behaviors::behaviors_manager::create_functions_table(const std::stri
     std::string name = std::to_string(impl->behaviors_id_iterator);
     impl->behaviors_id_iterator++;
 
-    std::string path = filesystem::get_global_path(file_path);
-
     int error;
-    error = luaL_loadfile(L, path.c_str());
+    error = impl->load_chunk(file_path);
 
     if (error != LUA_OK)
         error_handling::crash(error_handling::error_source::core, "[behaviors_manager::create_behavior]", lua_tostring(L, -1));
@@ -203,12 +705,112 @@ void behaviors::behaviors_manager::destroy_functions_table(const std::string& ta
     lua_setfield(impl->L, LUA_REGISTRYINDEX, table_name.c_str());
 }
 
-void behaviors::behaviors_manager::pass_entity_arg(std::weak_ptr<entities::entity>* entity)
+void behaviors::behaviors_manager::create_function_refs(const std::string& table_name, function_refs& refs)
+{
+    static const char* names[functions_count] = { "on_init", "on_update", "on_destroy", "on_overlap", "on_collide", "on_update_batch" };
+
+    auto& L = impl->L;
+    lua_getfield(L, LUA_REGISTRYINDEX, table_name.c_str());
+    for (size_t i = 0; i < functions_count; i++)
+    {
+        lua_getfield(L, -1, names[i]);
+        //nil gives LUA_REFNIL, so missing functions are negative
+        refs.refs[i] = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+    lua_pop(L, 1);
+
+    if (refs.implements(functions::update_batch))
+    {
+        lua_newtable(L);
+        refs.batch_entities = luaL_ref(L, LUA_REGISTRYINDEX);
+        lua_newtable(L);
+        refs.batch_selves = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+    refs.state_generation = impl->state_generation;
+}
+
+void behaviors::behaviors_manager::destroy_function_refs(function_refs& refs)
+{
+    if (refs.state_generation != impl->state_generation)
+        return;
+
+    for (auto& ref : refs.refs)
+    {
+        luaL_unref(impl->L, LUA_REGISTRYINDEX, ref);
+        ref = LUA_REFNIL;
+    }
+    luaL_unref(impl->L, LUA_REGISTRYINDEX, refs.batch_entities);
+    luaL_unref(impl->L, LUA_REGISTRYINDEX, refs.batch_selves);
+    refs.batch_entities = LUA_REFNIL;
+    refs.batch_selves = LUA_REFNIL;
+}
+
+void behaviors::behaviors_manager::pass_entity_arg(entities::entity_handle entity)
+{
+    lua_shared::entity_reference::push(impl->L, entity);
+}
+
+void behaviors::behaviors_manager::release_entity_reference(int reference)
+{
+    lua_shared::entity_reference::release(impl->L, reference);
+}
+
+std::shared_ptr<behaviors::behavior_stats> behaviors::behaviors_manager::get_behavior_stats(const std::string& file_path)
+{
+    auto& stats = impl->behaviors_stats[file_path];
+    if (stats == nullptr)
+        stats = std::make_shared<behavior_stats>();
+    return stats;
+}
+
+void behaviors::behaviors_manager::set_frame_budget(double milliseconds)
 {
-    void* data = (lua_newuserdata(impl->L, sizeof(*entity)));
-    auto ptr = new(data) std::weak_ptr<::entities::entity>(*entity);
-    luaL_getmetatable(impl->L, "entity");
-    lua_setmetatable(impl->L, -2);
+    impl->frame_budget = milliseconds / 1000.0;
+}
+
+void behaviors::behaviors_manager::set_instructions_limit(uint64_t instructions)
+{
+    impl->instructions_limit = instructions;
+}
+
+std::vector<std::pair<std::string, behaviors::behavior_stats>> behaviors::behaviors_manager::get_most_expensive_behaviors(size_t amount)
+{
+    std::vector<std::pair<std::string, behavior_stats>> result;
+    result.reserve(impl->behaviors_stats.size());
+    for (auto& stats : impl->behaviors_stats)
+        result.push_back({ stats.first, *stats.second });
+
+    amount = std::min(amount, result.size());
+    std::partial_sort(result.begin(), result.begin() + amount, result.end(),
+        [](const auto& a, const auto& b) { return a.second.seconds > b.second.seconds; });
+    result.resize(amount);
+    return result;
+}
+
+void behaviors::behaviors_manager::reset_behaviors_stats()
+{
+    for (auto& stats : impl->behaviors_stats)
+        *stats.second = {};
+}
+
+void behaviors::behaviors_manager::set_memory_limit(size_t bytes)
+{
+    impl->allocator->set_limit(bytes);
+}
+
+void behaviors::behaviors_manager::set_incremental_gc(int pause, int step_multiplier, int step_size)
+{
+    lua_gc(impl->L, LUA_GCINC, pause, step_multiplier, step_size);
+}
+
+void behaviors::behaviors_manager::set_generational_gc(int minor_multiplier, int major_multiplier)
+{
+    lua_gc(impl->L, LUA_GCGEN, minor_multiplier, major_multiplier);
+}
+
+const behaviors::lua_memory_stats& behaviors::behaviors_manager::get_memory_stats()
+{
+    return impl->allocator->get_stats();
 }
 
 void behaviors::behaviors_manager::pass_float_arg(float arg)
@@ -216,6 +818,21 @@ void behaviors::behaviors_manager::pass_float_arg(float arg)
     lua_pushnumber(impl->L, arg);
 }
 
+void behaviors::behaviors_manager::pass_integer_arg(int64_t arg)
+{
+    lua_pushinteger(impl->L, static_cast<lua_Integer>(arg));
+}
+
+void behaviors::behaviors_manager::pass_bool_arg(bool arg)
+{
+    lua_pushboolean(impl->L, arg);
+}
+
+void behaviors::behaviors_manager::pass_string_arg(const std::string& arg)
+{
+    lua_pushlstring(impl->L, arg.c_str(), arg.size());
+}
+
 void behaviors::behaviors_manager::pass_nil()
 {
     lua_pushnil(impl->L);
@@ -228,29 +845,23 @@ void behaviors::behaviors_manager::pass_custom_function_args(const int& args_reg
 
 bool behaviors::behaviors_manager::prepare_behavior_function_call(behaviors::functions func, assets::behavior* bhv)
 {
-    lua_getfield(impl->L, LUA_REGISTRYINDEX, bhv->name.c_str());
-    switch (func)
-    {
-    case behaviors::functions::init:
-        lua_getfield(impl->L, -1, "on_init"); break;
-    case behaviors::functions::update:
-        lua_getfield(impl->L, -1, "on_update"); break;
-    case behaviors::functions::destroy:
-        lua_getfield(impl->L, -1, "on_destroy"); break;
-    case behaviors::functions::on_collide:
-        lua_getfield(impl->L, -1, "on_collide"); break;
-    case behaviors::functions::on_overlap:
-        lua_getfield(impl->L, -1, "on_overlap"); break;
-    }
-    lua_remove(impl->L, -2);
-    if (lua_isnil(impl->L, -1))
-    {
-        lua_pop(impl->L, -1);
+    if (!bhv->function_refs.implements(func))
         return false;
-    }
+    lua_rawgeti(impl->L, LUA_REGISTRYINDEX, bhv->function_refs.get(func));
+    impl->next_call_stats = bhv->stats.get();
     return true;
 }
 
+void behaviors::behaviors_manager::prepare_reference_call(int reference)
+{
+    lua_rawgeti(impl->L, LUA_REGISTRYINDEX, reference);
+}
+
+void behaviors::behaviors_manager::release_reference(int reference)
+{
+    luaL_unref(impl->L, LUA_REGISTRYINDEX, reference);
+}
+
 bool behaviors::behaviors_manager::prepare_custom_behavior_function_call(const std::string& func_name, assets::behavior* bhv, const int& args_registry_id)
 {
     lua_getfield(impl->L, LUA_REGISTRYINDEX, bhv->name.c_str());
@@ -262,6 +873,7 @@ bool behaviors::behaviors_manager::prepare_custom_behavior_function_call(const s
         lua_remove(impl->L, 1);
         return false;
     }
+    impl->next_call_stats = bhv->stats.get();
     return true;
 }
 
@@ -288,20 +900,16 @@ bool behaviors::behaviors_manager::prepare_scene_function_call(behaviors::functi
 
 int behaviors::behaviors_manager::call(int args_amount, int results)
 {
-    if (impl->frames_stack.back().target_object_database.get() == nullptr)
-    {
-        lua_pushnil(impl->L);
-        lua_setglobal(impl->L, "self");
-    }
-    else
-    {
-        lua_rawgeti(impl->L, LUA_REGISTRYINDEX, impl->frames_stack.back().target_object_database->table_ref);
-        lua_setglobal(impl->L, "self");
-    }
+    impl->bind_self();
 
     int stack_size = lua_gettop(impl->L);
 
+    impl->begin_profiled_call();
     auto err = lua_pcall(impl->L, args_amount, results, 0);
+    impl->end_profiled_call();
+    if (err == LUA_ERRMEM)
+        error_handling::crash(error_handling::error_source::mod, "[behaviors_manager::call]", 
+            "Lua memory limit exceeded (" + std::to_string(impl->allocator->get_stats().allocated / 1024) + "KB allocated)");
     if (err != LUA_OK)
         error_handling::crash(error_handling::error_source::core, "[behaviors_manager::call]", lua_tostring(impl->L, -1));
 
@@ -326,16 +934,7 @@ void behaviors::behaviors_manager::create_frame(std::shared_ptr<database> databa
 void behaviors::behaviors_manager::pop_frame()
 {
     impl->frames_stack.pop_back();
-    if (impl->frames_stack.size() == 0 || impl->frames_stack.back().target_object_database == nullptr)
-    {
-        lua_pushnil(impl->L);
-        lua_setglobal(impl->L, "self");
-    }
-    else
-    {
-        lua_rawgeti(impl->L, LUA_REGISTRYINDEX, impl->frames_stack.back().target_object_database->table_ref);
-        lua_setglobal(impl->L, "self");
-    }
+    impl->bind_self();
 }
 
 const behaviors::frame* behaviors::behaviors_manager::get_current_frame()
@@ -1,8 +1,12 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <vector>
 #include "behavior_functions.h"
+#include "behavior_stats.h"
+#include "lua_allocator.h"
 #include "behaviors_database.h"
+#include "source/entities/entity_registry.h"
 
 namespace assets
 {
@@ -26,6 +30,11 @@ namespace behaviors
 	struct frame;
 }
 
+namespace events
+{
+	class event_bus;
+}
+
 struct lua_State;
 
 namespace behaviors
@@ -41,6 +50,7 @@ namespace behaviors
 	friend entities::scene;
 	friend entities::components::behavior;
 	friend database;
+	friend events::event_bus;
 	public:
 		behaviors_manager();
 		~behaviors_manager();
@@ -51,6 +61,7 @@ namespace behaviors
 		/*
 			call_update_functions
 			calls on_update on every registered behavior component
+			behaviors implementing on_update_batch are called once with all their components instead
 		*/
 		void call_update_functions();
 		/*
@@ -74,6 +85,107 @@ namespace behaviors
 			loads lua module (if not already loaded) and puts it on the stack
 		*/
 		void require_module(const std::string& path);
+		/*
+			release_entity_reference
+			frees entity userdata cached in the lua registry
+			called by the entity destructor
+		*/
+		void release_entity_reference(int reference);
+		/*
+			set_frame_budget
+			once on_update calls take more than the budget in a frame,
+			low priority behaviors are deferred, each one at most for max_deferred_time
+			-l-
+			[milliseconds] 0 disables the budget
+		*/
+		void set_frame_budget(double milliseconds);
+		/*
+			set_instructions_limit
+			behavior call executing more instructions than the limit is stopped with an error
+			-l-
+			[instructions] 0 disables the limit
+		*/
+		void set_instructions_limit(uint64_t instructions);
+		/*
+			get_most_expensive_behaviors
+			returns stats of the behaviors that took the most time, sorted from the most expensive
+			-l-
+			[amount] max amount of returned behaviors
+		*/
+		std::vector<std::pair<std::string, behavior_stats>> get_most_expensive_behaviors(size_t amount);
+		/*
+			reset_behaviors_stats
+			called when the mod is unloaded, so stats of the next mod start from zero
+		*/
+		void reset_behaviors_stats();
+		/*
+			set_memory_limit
+			lua allocations exceeding the limit fail with the memory error
+			-l-
+			[bytes] 0 disables the limit
+		*/
+		void set_memory_limit(size_t bytes);
+		/*
+			set_incremental_gc
+			switches lua garbage collector to the incremental mode
+			0 keeps the default value of the parameter
+		*/
+		void set_incremental_gc(int pause, int step_multiplier, int step_size);
+		/*
+			set_generational_gc
+			switches lua garbage collector to the generational mode
+			0 keeps the default value of the parameter
+		*/
+		void set_generational_gc(int minor_multiplier, int major_multiplier);
+		/*
+			get_memory_stats
+			returns memory stats of the current lua state
+		*/
+		const lua_memory_stats& get_memory_stats();
+		/*
+			start_task
+			runs the function as a coroutine task until its first wait
+			task belongs to the self of the current frame (or to its scene) and is cancelled when it is destroyed
+			-l-
+			[L]			state or thread with the function and its arguments on the top of the stack
+			[arguments]	amount of arguments above the function
+		*/
+		void start_task(lua_State* L, int arguments);
+		/*
+			is_in_task
+			returns true if L is the thread of the currently running task
+		*/
+		bool is_in_task(lua_State* L);
+		/*
+			wait_seconds, wait_frames, wait_signal
+			schedule the current task to be resumed, the task has to yield after the call
+			sleeping tasks cost nothing until they are resumed
+		*/
+		void wait_seconds(double seconds);
+		void wait_frames(uint64_t frames);
+		void wait_signal(const std::string& signal);
+		/*
+			signal
+			resumes all tasks waiting for the signal at the beginning of the next update
+		*/
+		void signal(const std::string& signal);
+		/*
+			cancel_scene_tasks
+			cancels tasks of the scene and of the behaviors called in its context
+			called by the scene destructor
+		*/
+		void cancel_scene_tasks(entities::scene* scene);
+		/*
+			cancel_database_tasks
+			cancels tasks started by the behavior owning the database
+			called by the behavior component destructor, so tasks waiting for a signal don't outlive it
+		*/
+		void cancel_database_tasks(const std::shared_ptr<database>& db);
+		/*
+			max_deferred_time
+			how long low priority behavior can be deferred by the frame budget, in seconds
+		*/
+		static constexpr double max_deferred_time = 0.25;
 	private:
 		struct implementation;
 		implementation* impl;
@@ -105,6 +217,36 @@ namespace behaviors
 			[table_name] name of the table, returned by create_functions_table
 		*/
 		void destroy_functions_table(const std::string& table_name);
+		/*
+			create_function_refs
+			resolves behavior functions from the functions table to registry references,
+			so calls skip the table lookups
+			-l-
+			[table_name] name of the table, returned by create_functions_table
+		*/
+		void create_function_refs(const std::string& table_name, function_refs& refs);
+		/*
+			destroy_function_refs
+			frees references created by create_function_refs
+		*/
+		void destroy_function_refs(function_refs& refs);
+		/*
+			get_behavior_stats
+			returns stats entry of the behavior file, creates it if needed
+		*/
+		std::shared_ptr<behavior_stats> get_behavior_stats(const std::string& file_path);
+		/*
+			resume_task
+			resumes the task, destroys it when it finishes
+			-l-
+			[from] state or thread resuming the task
+		*/
+		void resume_task(uint64_t id, lua_State* from);
+		/*
+			update_tasks
+			resumes tasks which wait time or frames passed, or which were signaled
+		*/
+		void update_tasks();
 		/*
 			prepare_behavior_function_call
 			informs lua environement about incoming behavior function call
@@ -136,6 +278,18 @@ namespace behaviors
 			[sc]		scene asset from whose function should be called
 		*/
 		bool prepare_scene_function_call(behaviors::functions func, assets::scene* sc);
+		/*
+			prepare_reference_call
+			informs lua environement about incoming call of the function stored in the registry
+			-l-
+			[reference] registry reference of the function
+		*/
+		void prepare_reference_call(int reference);
+		/*
+			release_reference
+			frees registry reference
+		*/
+		void release_reference(int reference);
 		/*
 			call
 			calls behaviors function
@@ -145,8 +299,11 @@ namespace behaviors
 			[return value] amount of functions results limited by results_amount
 		*/
 		int call(int args_amount, int results_amount);
-		void pass_entity_arg(std::weak_ptr<entities::entity>* entity);
+		void pass_entity_arg(entities::entity_handle entity);
 		void pass_float_arg(float arg);
+		void pass_integer_arg(int64_t arg);
+		void pass_bool_arg(bool arg);
+		void pass_string_arg(const std::string& arg);
 		void pass_nil();
 		/*
 			pass_custom_function_args
@@ -0,0 +1,118 @@
+#include "lua_allocator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+behaviors::lua_allocator::~lua_allocator()
+{
+	for (auto& page : pages)
+		std::free(page);
+}
+
+void* behaviors::lua_allocator::allocate(void* ud, void* ptr, size_t old_size, size_t new_size)
+{
+	auto self = static_cast<lua_allocator*>(ud);
+
+	//for new blocks lua passes the object type as the old_size
+	if (ptr == nullptr)
+		old_size = 0;
+
+	if (new_size == 0)
+	{
+		if (ptr != nullptr)
+		{
+			if (old_size <= max_pooled_size)
+				self->pool_free(ptr, get_size_class(old_size));
+			else
+				std::free(ptr);
+			self->stats.allocated -= old_size;
+		}
+		return nullptr;
+	}
+
+	//shrinking is never refused, lua expects it to succeed
+	if (self->limit != 0 && new_size > old_size && self->stats.allocated + (new_size - old_size) > self->limit)
+	{
+		self->stats.refused_allocations++;
+		return nullptr;
+	}
+
+	void* result = self->reallocate(ptr, old_size, new_size);
+	if (result == nullptr)
+		return nullptr;
+
+	self->stats.allocated += new_size;
+	self->stats.allocated -= old_size;
+	self->stats.peak_allocated = std::max(self->stats.peak_allocated, self->stats.allocated);
+	return result;
+}
+
+void* behaviors::lua_allocator::reallocate(void* ptr, size_t old_size, size_t new_size)
+{
+	bool old_pooled = ptr != nullptr && old_size <= max_pooled_size;
+	bool new_pooled = new_size <= max_pooled_size;
+
+	if (ptr != nullptr && old_pooled && new_pooled && get_size_class(old_size) == get_size_class(new_size))
+		return ptr;
+
+	if (ptr != nullptr && !old_pooled && !new_pooled)
+	{
+		stats.allocations++;
+		stats.large_allocations++;
+		return std::realloc(ptr, new_size);
+	}
+
+	void* result;
+	stats.allocations++;
+	if (new_pooled)
+		result = pool_allocate(get_size_class(new_size));
+	else
+	{
+		stats.large_allocations++;
+		result = std::malloc(new_size);
+	}
+
+	if (result == nullptr || ptr == nullptr)
+		return result;
+
+	std::memcpy(result, ptr, std::min(old_size, new_size));
+	if (old_pooled)
+		pool_free(ptr, get_size_class(old_size));
+	else
+		std::free(ptr);
+	return result;
+}
+
+void* behaviors::lua_allocator::pool_allocate(size_t size_class)
+{
+	if (free_lists[size_class] == nullptr)
+	{
+		size_t block_size = (size_class + 1) * granularity;
+		char* page = static_cast<char*>(std::malloc(page_size));
+		if (page == nullptr)
+			return nullptr;
+		pages.push_back(page);
+		stats.pooled += page_size;
+
+		//carve the page into blocks, so the first block is at the front of the list
+		size_t blocks = page_size / block_size;
+		for (size_t i = blocks; i-- > 0;)
+		{
+			auto block = reinterpret_cast<free_block*>(page + i * block_size);
+			block->next = free_lists[size_class];
+			free_lists[size_class] = block;
+		}
+	}
+
+	free_block* block = free_lists[size_class];
+	free_lists[size_class] = block->next;
+	return block;
+}
+
+void behaviors::lua_allocator::pool_free(void* ptr, size_t size_class)
+{
+	auto block = static_cast<free_block*>(ptr);
+	block->next = free_lists[size_class];
+	free_lists[size_class] = block;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace behaviors
+{
+	/*
+		lua_memory_stats
+		memory used by the lua state of the current mod
+	*/
+	struct lua_memory_stats
+	{
+		//bytes requested by lua
+		size_t allocated = 0;
+		size_t peak_allocated = 0;
+		//bytes of pool pages, including the free blocks
+		size_t pooled = 0;
+		uint64_t allocations = 0;
+		//allocations too big for the pools, served by malloc
+		uint64_t large_allocations = 0;
+		//allocations refused because of the limit
+		uint64_t refused_allocations = 0;
+	};
+
+	/*
+		lua_allocator
+		lua_Alloc serving small blocks from size class pools
+		pages are freed only when the allocator is destroyed, so it has to outlive its lua state
+		not thread safe, same as lua state
+	*/
+	class lua_allocator
+	{
+	public:
+		lua_allocator() {};
+		~lua_allocator();
+		lua_allocator(const lua_allocator&) = delete;
+		lua_allocator& operator=(const lua_allocator&) = delete;
+		/*
+			allocate
+			lua_Alloc function, ud has to point to the allocator
+		*/
+		static void* allocate(void* ud, void* ptr, size_t old_size, size_t new_size);
+		/*
+			set_limit
+			allocations that would exceed the limit fail, and lua raises memory error
+			-l-
+			[bytes] 0 disables the limit
+		*/
+		void set_limit(size_t bytes) { limit = bytes; };
+		const lua_memory_stats& get_stats() { return stats; };
+	private:
+		static constexpr size_t granularity = 16;
+		static constexpr size_t max_pooled_size = 256;
+		static constexpr size_t size_classes = max_pooled_size / granularity;
+		static constexpr size_t page_size = 64 * 1024;
+
+		struct free_block
+		{
+			free_block* next;
+		};
+
+		free_block* free_lists[size_classes] = {};
+		std::vector<void*> pages;
+		size_t limit = 0;
+		lua_memory_stats stats;
+
+		//only for sizes from 1 to max_pooled_size
+		static size_t get_size_class(size_t size) { return (size + granularity - 1) / granularity - 1; };
+		void* pool_allocate(size_t size_class);
+		void pool_free(void* ptr, size_t size_class);
+		void* reallocate(void* ptr, size_t old_size, size_t new_size);
+	};
+}
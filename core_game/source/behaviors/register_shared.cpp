@@ -12,6 +12,9 @@
 #include "source/behaviors_shared/components_functions.h"
 #include "source/behaviors_shared/input_functions.h"
 #include "source/behaviors_shared/collision_functions.h"
+#include "source/behaviors_shared/profiler_functions.h"
+#include "source/behaviors_shared/task_functions.h"
+#include "source/behaviors_shared/events_functions.h"
 
 void behaviors::register_shared(lua_State* L)
 {
@@ -25,4 +28,7 @@ void behaviors::register_shared(lua_State* L)
 	lua_shared::components::register_shared(L);
 	lua_shared::input::register_shared(L);
 	lua_shared::collision::register_shared(L);
+	lua_shared::profiler::register_shared(L);
+	lua_shared::task::register_shared(L);
+	lua_shared::events::register_shared(L);
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "timer_wheel.h"
+
+behaviors::timer_wheel::timer_wheel(size_t slots_amount) : slots(slots_amount)
+{
+}
+
+void behaviors::timer_wheel::schedule(uint64_t id, uint64_t ticks)
+{
+	if (ticks == 0)
+		ticks = 1;
+	size_t slot = (current + ticks % slots.size()) % slots.size();
+	slots.at(slot).push_back({ id, (ticks - 1) / slots.size() });
+}
+
+void behaviors::timer_wheel::advance(uint64_t ticks, std::vector<uint64_t>& expired)
+{
+	for (uint64_t i = 0; i < ticks; i++)
+	{
+		current = (current + 1) % slots.size();
+		auto& slot = slots.at(current);
+
+		size_t kept = 0;
+		for (size_t j = 0; j < slot.size(); j++)
+		{
+			if (slot[j].rounds == 0)
+				expired.push_back(slot[j].id);
+			else
+			{
+				slot[j].rounds--;
+				slot[kept++] = slot[j];
+			}
+		}
+		slot.resize(kept);
+	}
+}
+
+void behaviors::timer_wheel::clear()
+{
+	for (auto& slot : slots)
+		slot.clear();
+	current = 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace behaviors
+{
+	/*
+		timer_wheel
+		schedules ids to expire after given amount of ticks
+		scheduling is O(1), advancing visits only the slots that passed
+	*/
+	class timer_wheel
+	{
+	public:
+		timer_wheel(size_t slots_amount = 256);
+		/*
+			schedule
+			id will be expired by the ticks-th advanced tick
+			-l-
+			[ticks] at least 1, 0 is treated as 1
+		*/
+		void schedule(uint64_t id, uint64_t ticks);
+		/*
+			advance
+			moves the wheel by the given amount of ticks and appends expired ids to expired
+		*/
+		void advance(uint64_t ticks, std::vector<uint64_t>& expired);
+		void clear();
+	private:
+		struct entry
+		{
+			uint64_t id;
+			//full turns of the wheel left before the entry expires
+			uint64_t rounds;
+		};
+		std::vector<std::vector<entry>> slots;
+		size_t current = 0;
+	};
+}
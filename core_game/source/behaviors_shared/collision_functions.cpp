@@ -4,27 +4,162 @@
 
 #include "source/common/common.h"
 #include "source/physics/collision_solver.h"
+#include "source/entities/entity.h"
 
 #include "source/assets/collision_config_asset.h"
 
 #include "include/glm/glm.hpp"
 
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
 namespace behaviors
 {
 	namespace lua_shared
 	{
 		namespace collision
 		{
-			int _cl_trace(lua_State* L)
+			//colliders found by the queries, reused between calls
+			static std::vector<entities::components::collider*> query_result;
+			//segments and hits of the batched traces, reused between calls
+			static std::vector<glm::vec2> trace_segments;
+			static std::vector<physics::collision_event> trace_nearest_hits;
+			static std::vector<std::vector<physics::collision_event>> trace_all_hits;
+
+			//sets to nil array entries of the table starting at first, until the first nil
+			void clear_from(lua_State* L, int table_index, lua_Integer first)
+			{
+				table_index = lua_absindex(L, table_index);
+				for (lua_Integer i = first; lua_rawgeti(L, table_index, i) != LUA_TNIL; i++)
+				{
+					lua_pop(L, 1);
+					lua_pushnil(L);
+					lua_rawseti(L, table_index, i);
+				}
+				lua_pop(L, 1);
+			}
+
+			//writes hit into the table at the top of the stack, fields are nil if nothing was hit
+			void write_hit(lua_State* L, const physics::collision_event& hit)
+			{
+				if (hit.response != physics::collision_response::ignore && !hit.other->get_owner()->is_kill_queued())
+				{
+					push_entity_to_table(L, "entity", hit.other->get_owner_handle());
+					push_number_to_table(L, "distance", hit.distance);
+					push_number_to_table(L, "x", hit.location.x);
+					push_number_to_table(L, "y", hit.location.y);
+				}
+				else
+				{
+					push_nil_to_table(L, "entity");
+					push_nil_to_table(L, "distance");
+					push_nil_to_table(L, "x");
+					push_nil_to_table(L, "y");
+				}
+			}
+
+			physics::collision_preset load_preset(lua_State* L, int index)
+			{
+				if (lua_isnoneornil(L, index))
+					return 0;
+				std::string preset_name = lua_tostring(L, index);
+				auto config = ::assets::cast_asset<::assets::collision_config>(
+					::common::assets_manager->get_asset(utilities::hash_string("mod/collision_config")));
+				return config.lock()->get_preset(utilities::hash_string(preset_name));
+			}
+
+			int load_layer(lua_State* L, int index)
 			{
-				physics::collision_preset trace_preset;
+				if (lua_isnoneornil(L, index))
+					return physics::collision_solver::any_layer;
+				return static_cast<int>(lua_tointeger(L, index));
+			}
+
+			/*
+				write_query_result
+				writes owners of the found colliders into the table at the given index as 1..n
+				entries left from a previous longer result are set to nil, so the table can be reused between calls
+			*/
+			int write_query_result(lua_State* L, int table_index)
+			{
+				std::sort(query_result.begin(), query_result.end(), [](
+					entities::components::collider* a,
+					entities::components::collider* b)
+					{
+						return a->get_owner() < b->get_owner();
+					});
+
+				lua_Integer count = 0;
+				entities::entity* previous = nullptr;
+				for (auto c : query_result)
 				{
-					std::string trace_preset_name = lua_tostring(L, 1);
-					auto config = ::assets::cast_asset<::assets::collision_config>(
-						::common::assets_manager->get_asset(utilities::hash_string("mod/collision_config")));
-					trace_preset = config.lock()->get_preset(utilities::hash_string(trace_preset_name));
+					auto owner = c->get_owner();
+					if (owner == previous || owner->is_kill_queued())
+						continue;
+					previous = owner;
+					push_entity(L, owner->get_handle());
+					lua_rawseti(L, table_index, ++count);
 				}
 
+				clear_from(L, table_index, count + 1);
+
+				query_result.clear();
+				lua_pushinteger(L, count);
+				return 1;
+			}
+
+			int _cl_query_box(lua_State* L)
+			{
+				glm::vec2 min = { static_cast<float>(lua_tonumber(L, 1)), static_cast<float>(lua_tonumber(L, 2)) };
+				glm::vec2 max = { static_cast<float>(lua_tonumber(L, 3)), static_cast<float>(lua_tonumber(L, 4)) };
+				luaL_checktype(L, 5, LUA_TTABLE);
+				auto filter = load_preset(L, 6);
+
+				common::collision_solver->query_box(glm::min(min, max), glm::max(min, max), filter, query_result, load_layer(L, 7));
+				return write_query_result(L, 5);
+			}
+
+			int _cl_query_circle(lua_State* L)
+			{
+				glm::vec2 center = { static_cast<float>(lua_tonumber(L, 1)), static_cast<float>(lua_tonumber(L, 2)) };
+				float radius = static_cast<float>(lua_tonumber(L, 3));
+				luaL_checktype(L, 4, LUA_TTABLE);
+				auto filter = load_preset(L, 5);
+
+				common::collision_solver->query_circle(center, radius, filter, query_result, load_layer(L, 6));
+				return write_query_result(L, 4);
+			}
+
+			int _cl_nearest(lua_State* L)
+			{
+				glm::vec2 point = { static_cast<float>(lua_tonumber(L, 1)), static_cast<float>(lua_tonumber(L, 2)) };
+				float max_distance = static_cast<float>(lua_tonumber(L, 3));
+				if (!std::isfinite(point.x) || !std::isfinite(point.y))
+					error_handling::crash(error_handling::error_source::mod, "[_cl_nearest]", "Point should be finite");
+				//math.huge means no limit, NaN is rejected by the comparison
+				if (!(max_distance >= 0))
+					error_handling::crash(error_handling::error_source::mod, "[_cl_nearest]", "Max distance should be a non-negative number");
+				auto filter = load_preset(L, 4);
+
+				float distance;
+				auto found = common::collision_solver->nearest(point, max_distance, filter, distance, load_layer(L, 5));
+				if (found == nullptr || found->get_owner()->is_kill_queued())
+				{
+					lua_pushnil(L);
+					lua_pushnil(L);
+					return 2;
+				}
+
+				push_entity(L, found->get_owner_handle());
+				lua_pushnumber(L, distance);
+				return 2;
+			}
+
+			int _cl_trace(lua_State* L)
+			{
+				physics::collision_preset trace_preset = load_preset(L, 1);
+
 				float start_x = static_cast<float>(lua_tonumber(L, 2));
 				float start_y = static_cast<float>(lua_tonumber(L, 3));
 				glm::vec2 start = { start_x, start_y };
@@ -33,33 +168,96 @@ namespace behaviors
 				float end_y = static_cast<float>(lua_tonumber(L, 5));
 				glm::vec2 end = { end_x, end_y };
 
-				auto event = common::collision_solver->check_if_ray_collide(
-					trace_preset,
-					start,
-					end - start
-				);
+				auto event = common::collision_solver->trace_nearest(trace_preset, start, end, load_layer(L, 6));
 
 				lua_newtable(L);
+				write_hit(L, event);
+
+				return 1;
+			}
+
+			int _cl_trace_batch(lua_State* L)
+			{
+				physics::collision_preset trace_preset = load_preset(L, 1);
+				luaL_checktype(L, 2, LUA_TTABLE);
+				luaL_checktype(L, 3, LUA_TTABLE);
+				bool all_hits = lua_toboolean(L, 4);
+				int layer = load_layer(L, 5);
 
-				if (event != nullptr && event->distance < glm::distance(start, end))
+				trace_segments.clear();
+				lua_Integer numbers_count = luaL_len(L, 2);
+				for (lua_Integer i = 1; i + 3 <= numbers_count; i += 4)
 				{
-					push_entity_to_table(L, "entity", event->other->get_owner_weak());
-					push_number_to_table(L, "distance", event->distance);
+					glm::vec2 segment[4];
+					for (int n = 0; n < 4; n++)
+					{
+						lua_rawgeti(L, 2, i + n);
+						segment[n / 2][n % 2] = static_cast<float>(lua_tonumber(L, -1));
+						lua_pop(L, 1);
+					}
+					trace_segments.push_back(segment[0]);
+					trace_segments.push_back(segment[1]);
 				}
+				lua_Integer rays_count = static_cast<lua_Integer>(trace_segments.size() / 2);
+
+				if (all_hits)
+					common::collision_solver->trace_batch(trace_preset, trace_segments, trace_all_hits, layer);
 				else
+					common::collision_solver->trace_batch(trace_preset, trace_segments, trace_nearest_hits, layer);
+
+				for (lua_Integer i = 1; i <= rays_count; i++)
 				{
-					push_nil_to_table(L, "entity");
-					push_nil_to_table(L, "distance");
-				}
+					//Tables already in results are reused
+					if (lua_rawgeti(L, 3, i) != LUA_TTABLE)
+					{
+						lua_pop(L, 1);
+						lua_newtable(L);
+						lua_pushvalue(L, -1);
+						lua_rawseti(L, 3, i);
+					}
+
+					if (all_hits)
+					{
+						auto& hits = trace_all_hits[i - 1];
+						lua_Integer count = 0;
+						for (auto& hit : hits)
+						{
+							if (hit.other->get_owner()->is_kill_queued())
+								continue;
+							//Hit tables are reused too, so a batch allocates only when it returns more hits than before
+							if (lua_rawgeti(L, -1, ++count) != LUA_TTABLE)
+							{
+								lua_pop(L, 1);
+								lua_newtable(L);
+								lua_pushvalue(L, -1);
+								lua_rawseti(L, -3, count);
+							}
+							write_hit(L, hit);
+							lua_pushstring(L, "blocking");
+							lua_pushboolean(L, hit.response == physics::collision_response::collide);
+							lua_settable(L, -3);
+							lua_pop(L, 1);
+						}
+						clear_from(L, -1, count + 1);
+					}
+					else
+						write_hit(L, trace_nearest_hits[i - 1]);
 
-				delete event;
+					lua_pop(L, 1);
+				}
+				clear_from(L, 3, rays_count + 1);
 
+				lua_pushinteger(L, rays_count);
 				return 1;
 			}
 
 			void register_shared(lua_State* L)
 			{
 				lua_register(L, "_cl_trace", _cl_trace);
+				lua_register(L, "_cl_trace_batch", _cl_trace_batch);
+				lua_register(L, "_cl_query_box", _cl_query_box);
+				lua_register(L, "_cl_query_circle", _cl_query_circle);
+				lua_register(L, "_cl_nearest", _cl_nearest);
 			}
 		}
 	}
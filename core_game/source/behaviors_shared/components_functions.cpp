@@ -317,10 +317,10 @@ namespace behaviors
 					utilities::hash_string("mod/collision_config"))).lock();
 
 				auto it = std::find_if(config->collision_presets.begin(), config->collision_presets.end(),
-					[&ptr](auto&& p) { return p.second == ptr->preset; });
+					[&ptr](auto&& p) { return p.second == ptr->get_preset(); });
 
 				if (it == config->collision_presets.end())
-					lua_pushinteger(L, ptr->preset);
+					lua_pushinteger(L, ptr->get_preset());
 				else
 					lua_pushstring(L, config->collision_presets_names.at(it->first).c_str());
 
@@ -336,53 +336,51 @@ namespace behaviors
 					::common::assets_manager->get_asset(utilities::hash_string("mod/collision_config")));
 
 				if (ptr != nullptr)
-					ptr->preset = config.lock()->get_preset(utilities::hash_string(preset));
+					ptr->set_preset(config.lock()->get_preset(utilities::hash_string(preset)));
 				return 0;
 			}
 
 			int _c_cl_get_offset(lua_State* L)
 			{
 				auto cl = load_component<::entities::components::collider>(L, "[_c_cl_get_offset]");
-				lua_pushnumber(L, cl->entity_offset.x);
-				lua_pushnumber(L, cl->entity_offset.y);
+				lua_pushnumber(L, cl->get_entity_offset().x);
+				lua_pushnumber(L, cl->get_entity_offset().y);
 				return 2;
 			}
 
 			int _c_cl_set_offset(lua_State* L)
 			{
 				auto cl = load_component<::entities::components::collider>(L, "[_c_cl_set_offset]");
-				cl->entity_offset.x = static_cast<float>(lua_tonumber(L, 3));
-				cl->entity_offset.y = static_cast<float>(lua_tonumber(L, 4));
+				cl->set_entity_offset({ static_cast<float>(lua_tonumber(L, 3)), static_cast<float>(lua_tonumber(L, 4)) });
 				return 0;
 			}
 
 			int _c_cl_get_extend(lua_State* L)
 			{
 				auto cl = load_component<::entities::components::collider>(L, "[_c_cl_get_extend]");
-				lua_pushnumber(L, cl->extend.x);
-				lua_pushnumber(L, cl->extend.y);
+				lua_pushnumber(L, cl->get_extend().x);
+				lua_pushnumber(L, cl->get_extend().y);
 				return 2;
 			}
 
 			int _c_cl_set_extend(lua_State* L)
 			{
 				auto cl = load_component<::entities::components::collider>(L, "[_c_cl_set_extend]");
-				cl->extend.x = static_cast<float>(lua_tonumber(L, 3));
-				cl->extend.y = static_cast<float>(lua_tonumber(L, 4));
+				cl->set_extend({ static_cast<float>(lua_tonumber(L, 3)), static_cast<float>(lua_tonumber(L, 4)) });
 				return 0;
 			}
 
 			int _c_cl_get_layer_offset(lua_State* L)
 			{
 				auto cl = load_component<::entities::components::collider>(L, "[_c_cl_get_layer_offset]");
-				lua_pushinteger(L, cl->layer_offset);
+				lua_pushinteger(L, cl->get_layer_offset());
 				return 1;
 			}
 
 			int _c_cl_set_layer_offset(lua_State* L)
 			{
 				auto cl = load_component<::entities::components::collider>(L, "[_c_cl_set_layer_offset]");
-				cl->layer_offset = static_cast<int>(lua_tointeger(L, 3));
+				cl->set_layer_offset(static_cast<int>(lua_tointeger(L, 3)));
 				return 0;
 			}
 
@@ -421,7 +419,7 @@ namespace behaviors
 			int _c_d_get_drag(lua_State* L)
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_get_drag]");
-				lua_pushnumber(L, d->drag);
+				lua_pushnumber(L, d->get_drag());
 				return 1;
 			}
 
@@ -429,14 +427,14 @@ namespace behaviors
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_set_drag]");
 				auto drag = static_cast<float>(lua_tonumber(L, 3));
-				d->drag = drag;
+				d->set_drag(drag);
 				return 0;
 			}
 
 			int _c_d_get_mass(lua_State* L)
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_get_mass]");
-				lua_pushnumber(L, d->mass);
+				lua_pushnumber(L, d->get_mass());
 				return 1;
 			}
 
@@ -444,14 +442,14 @@ namespace behaviors
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_set_mass]");
 				auto mass = static_cast<float>(lua_tonumber(L, 3));
-				d->mass = mass;
+				d->set_mass(mass);
 				return 0;
 			}
 
 			int _c_d_get_use_max_vel(lua_State* L)
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_get_use_max_vel]");
-				lua_pushboolean(L, d->use_maximum_velocity);
+				lua_pushboolean(L, d->get_use_maximum_velocity());
 				return 1;
 			}
 
@@ -459,14 +457,14 @@ namespace behaviors
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_set_use_max_vel]");
 				auto use = lua_toboolean(L, 3);
-				d->use_maximum_velocity = use;
+				d->set_use_maximum_velocity(use);
 				return 0;
 			}
 
 			int _c_d_get_max_vel(lua_State* L)
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_get_max_vel]");
-				lua_pushnumber(L, d->maximum_velocity);
+				lua_pushnumber(L, d->get_maximum_velocity());
 				return 1;
 			}
 
@@ -494,14 +492,14 @@ namespace behaviors
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_set_max_vel]");
 				auto vel = static_cast<float>(lua_tonumber(L, 3));
-				d->maximum_velocity = vel;
+				d->set_maximum_velocity(vel);
 				return 0;
 			}
 
 			int _c_d_get_gravity_enabled(lua_State* L)
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_set_max_vel]");
-				lua_pushboolean(L, d->gravity_enabled);
+				lua_pushboolean(L, d->get_gravity_enabled());
 				return 1;
 			}
 
@@ -509,7 +507,7 @@ namespace behaviors
 			{
 				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_set_max_vel]");
 				bool enabled = lua_toboolean(L, 3);
-				d->gravity_enabled = enabled;
+				d->set_gravity_enabled(enabled);
 				return 0;
 			}
 
@@ -520,6 +518,20 @@ namespace behaviors
 				return 1;
 			}
 
+			int _c_d_get_sleeping(lua_State* L)
+			{
+				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_get_sleeping]");
+				lua_pushboolean(L, d->get_sleeping());
+				return 1;
+			}
+
+			int _c_d_wake_up(lua_State* L)
+			{
+				auto d = load_component<::entities::components::dynamics>(L, "[_c_d_wake_up]");
+				d->wake_up();
+				return 0;
+			}
+
 			/*
 				Tilemap
 			*/
@@ -636,6 +648,8 @@ namespace behaviors
 				lua_register(L, "_c_d_get_gravity_enabled", _c_d_get_gravity_enabled);
 				lua_register(L, "_c_d_set_gravity_enabled", _c_d_set_gravity_enabled);
 				lua_register(L, "_c_d_get_grounded", _c_d_get_grounded);
+				lua_register(L, "_c_d_get_sleeping", _c_d_get_sleeping);
+				lua_register(L, "_c_d_wake_up", _c_d_wake_up);
 				
 				lua_register(L, "_c_t_get_layers_stride", _c_t_get_layers_stride);
 				lua_register(L, "_c_t_set_layers_stride", _c_t_set_layers_stride);
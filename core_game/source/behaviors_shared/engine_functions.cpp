@@ -14,8 +14,20 @@
 #include "source/entities/entity.h"
 
 #include "source/components/camera.h"
+#include "source/components/behavior.h"
+#include "source/components/collider.h"
+#include "source/components/dynamics.h"
+#include "source/components/flipbook.h"
+#include "source/components/listener.h"
+#include "source/components/sound_emitter.h"
+
+#include "source/physics/collision_solver.h"
+#include "source/physics/dynamics_manager.h"
 
 #include "source/assets/custom_data_assset.h"
+#include "source/assets/prefab_asset.h"
+#include "source/assets/behavior_asset.h"
+#include "source/assets/flipbook_asset.h"
 
 namespace behaviors
 {
@@ -43,7 +55,7 @@ namespace behaviors
 			{
 				auto name = load_id(L, 1, "[_en_load_scene]", "Scene");
 
-				common::world->remove_scene(name);
+				common::world->get_commands().remove_scene(name);
 
 				return 0;
 			}
@@ -70,6 +82,93 @@ namespace behaviors
 				return 1;
 			}
 
+			::entities::component* create_prefab_component(const ::assets::prefab::component& c)
+			{
+				using type = ::entities::component_type;
+				switch (c.type)
+				{
+				case type::behavior:
+					return new ::entities::components::behavior{ c.id, ::assets::cast_asset<::assets::behavior>(c.resolved_asset) };
+				case type::camera:
+					return new ::entities::components::camera{ c.id, c.width };
+				case type::collider:
+					return new ::entities::components::collider{ c.id, c.preset, c.extend };
+				case type::dynamics:
+					return new ::entities::components::dynamics{ c.id };
+				case type::flipbook:
+					return new ::entities::components::flipbook{ c.id, ::assets::cast_asset<::assets::flipbook>(c.resolved_asset), c.preset, c.animation };
+				case type::listener:
+					return new ::entities::components::listener{ c.id };
+				case type::sound_emitter:
+					return new ::entities::components::sound_emitter{ c.id };
+				case type::sprite:
+					return new ::entities::components::sprite{ c.id, ::assets::cast_asset<::assets::texture>(c.resolved_asset), c.preset };
+				default:
+					return nullptr;
+				}
+			}
+
+			int _en_spawn_prefab(lua_State* L)
+			{
+				auto path = load_asset_path(L, 1, "[_en_spawn_prefab]");
+				if (!lua_istable(L, 2))
+					error_handling::crash(error_handling::error_source::mod, "[_en_spawn_prefab]",
+						"Positions should be a table of { x, y } tables");
+
+				auto prefab = ::assets::cast_asset<::assets::prefab>(common::assets_manager->safe_get_asset(path)).lock();
+				if (prefab == nullptr)
+					error_handling::crash(error_handling::error_source::mod, "[_en_spawn_prefab]", path + " isn't a prefab");
+				prefab->resolve();
+
+				std::vector<glm::vec2> positions(static_cast<size_t>(luaL_len(L, 2)));
+				for (size_t i = 0; i < positions.size(); i++)
+				{
+					lua_rawgeti(L, 2, static_cast<lua_Integer>(i + 1));
+					if (!lua_istable(L, -1))
+						error_handling::crash(error_handling::error_source::mod, "[_en_spawn_prefab]",
+							"Positions should be a table of { x, y } tables");
+					lua_rawgeti(L, -1, 1);
+					lua_rawgeti(L, -2, 2);
+					positions[i] = { static_cast<float>(lua_tonumber(L, -2)), static_cast<float>(lua_tonumber(L, -1)) };
+					lua_pop(L, 3);
+				}
+
+				//pools grow once for the whole batch
+				size_t colliders = 0, bodies = 0;
+				for (auto& c : prefab->components)
+					if (c.type == ::entities::component_type::collider || c.type == ::entities::component_type::sprite ||
+						c.type == ::entities::component_type::flipbook)
+						colliders++;
+					else if (c.type == ::entities::component_type::dynamics)
+						bodies++;
+				common::collision_solver->reserve(colliders * positions.size());
+				common::dynamics_manager->reserve(bodies * positions.size());
+
+				auto scene_context = common::behaviors_manager->get_current_frame()->scene_context;
+
+				lua_createtable(L, static_cast<int>(positions.size()), 0);
+				for (size_t i = 0; i < positions.size(); i++)
+				{
+					//location and layer are set before components are attached, so they aren't notified
+					auto e = new ::entities::entity{ scene_context };
+					e->set_layer(prefab->layer);
+					e->teleport(positions[i]);
+
+					for (auto& c : prefab->components)
+					{
+						auto comp = create_prefab_component(c);
+						e->attach_component(comp);
+						if (c.type == ::entities::component_type::sprite)
+							e->get_component<::entities::components::sprite>(c.id)->set_sprite_id(c.sprite_id);
+					}
+
+					push_entity(L, e->get_handle());
+					lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+				}
+
+				return 1;
+			}
+
 			std::string create_path(const std::string& path, const std::string& package)
 			{
 				if (path.at(0) == '$')
@@ -80,10 +179,10 @@ namespace behaviors
 			nlohmann::json load_template(std::string path)
 			{
 				filesystem::set_active_assets_directory_enabled(true);
-				auto file = filesystem::load_file(path);
+				auto data = filesystem::load_file_data(path);
 				filesystem::set_active_assets_directory_enabled(false);
 
-				auto _template = nlohmann::json::parse(file);
+				auto _template = nlohmann::json::parse(data);
 
 				if (!(_template.contains("object") && _template.at("object").is_object()))
 					error_handling::crash(error_handling::error_source::core, "[_en_create_entities_from_tilemap]",
@@ -102,9 +201,7 @@ namespace behaviors
 				filesystem::set_active_assets_directory(filesystem::get_owning_folder(tilemap_asset));
 				filesystem::set_active_assets_directory_enabled(true);
 
-				auto header_file = filesystem::load_file(tilemap_asset + ".json");
-				auto header = nlohmann::json::parse(header_file);
-				header_file.close();
+				auto header = nlohmann::json::parse(filesystem::load_file_data(tilemap_asset + ".json"));
 
 				if (!(header.contains("path") && header.at("path").is_string()))
 					error_handling::crash(error_handling::error_source::core, "[_en_create_entities_from_tilemap]",
@@ -112,9 +209,7 @@ namespace behaviors
 
 				auto tilemap_file_path = create_path(std::string(header.at("path")), filesystem::get_package(tilemap_asset));
 				
-				auto tilemap_file = filesystem::load_file(tilemap_file_path);
-				auto tilemap = nlohmann::json::parse(tilemap_file);
-				tilemap_file.close();
+				auto tilemap = nlohmann::json::parse(filesystem::load_file_data(tilemap_file_path));
 
 				std::string tilemap_folder = filesystem::get_owning_folder(tilemap_file_path) + "/";
 				filesystem::set_active_assets_directory_enabled(false);
@@ -155,9 +250,9 @@ namespace behaviors
 						float x = object.at("x");
 						float y = object.at("y");
 
-						std::weak_ptr<::entities::entity> e = (new ::entities::entity{ common::behaviors_manager->get_current_frame()->scene_context })->get_weak();
+						auto e = new ::entities::entity{ common::behaviors_manager->get_current_frame()->scene_context };
 
-						e.lock()->layer = layers_counter;
+						e->set_layer(static_cast<uint8_t>(layers_counter));
 
 						lua_rawgeti(L, LUA_REGISTRYINDEX, creator_function_ref);	//Restore the creator from registry
 
@@ -167,7 +262,7 @@ namespace behaviors
 						push_number_to_table(L, "object_layer", static_cast<float>(object_layers_counter));
 
 						lua_pushstring(L, "entity");
-						push_entity(L, e);
+						push_entity(L, e->get_handle());
 						lua_settable(L, -3);
 
 						bool templated = object.contains("template") && object.at("template").is_string();
@@ -209,7 +304,7 @@ namespace behaviors
 						float sx = static_cast<float>(x / common::pixels_per_world_unit - float(map_width) / (common::pixels_per_world_unit / 4.0));
 						float sy = static_cast<float>(-(y / common::pixels_per_world_unit - float(map_height) / (common::pixels_per_world_unit / 4.0)) - 0.5);
 
-						e.lock()->teleport({ sx, sy });
+						e->teleport({ sx, sy });
 
 						push_number_to_table(L, "x", sx);
 						push_number_to_table(L, "y", sy);
@@ -262,7 +357,7 @@ namespace behaviors
 				float y = static_cast<float>(lua_tonumber(L, 2));
 
 				auto cam = common::renderer->get_active_camera();
-				auto cam_loc = cam->get_owner_weak().lock()->get_location();
+				auto cam_loc = cam->get_owner()->get_location();
 
 				float wx, wy;
 
@@ -337,12 +432,9 @@ namespace behaviors
 				std::string filename = lua_tostring(L, 1);
 				filesystem::set_saved_directory_enabled(true);
 
-				auto file = filesystem::load_file(
+				auto data = nlohmann::json::parse(filesystem::load_file_data(
 					"saved/" + common::mods_manager->get_current_mod_name()  + '/' + filename + ".json"
-				);
-
-				auto data = nlohmann::json::parse(file);
-				file.close();
+				));
 
 				dump_json_to_table(L, &data, "[_en_load_data]");
 
@@ -366,6 +458,7 @@ namespace behaviors
 				lua_register(L, "_en_load_scene", _en_load_scene);
 				lua_register(L, "_en_unload_scene", _en_unload_scene);
 				lua_register(L, "_en_get_entities_in_scene", _en_get_entities_in_scene);
+				lua_register(L, "_en_spawn_prefab", _en_spawn_prefab);
 				lua_register(L, "_en_create_entities_from_tilemap", _en_create_entities_from_tilemap);
 				lua_register(L, "_en_viewport_to_world", _en_viewport_to_world);
 				lua_register(L, "_en_load_custom_data", _en_load_custom_data);
@@ -11,6 +11,8 @@
 
 #include "source/behaviors/frame.h"
 
+#include <vector>
+
 namespace behaviors
 {
 	namespace lua_shared
@@ -21,14 +23,14 @@ namespace behaviors
 			int _e_create(lua_State* L)
 			{
 				auto e = new ::entities::entity{scene};
-				push_entity(L, scene->entities.back());
+				push_entity(L, e->get_handle());
 				return 1;
 			}
 
 			int _e_kill(lua_State* L)
 			{
 				auto e = load_entity(L, 1, "[_e_kill]");
-				e->kill();
+				common::world->get_commands().kill(e->get_handle());
 				return 0;
 			}
 
@@ -36,12 +38,13 @@ namespace behaviors
 			{
 				if (!lua_isuserdata(L, 1))
 					error_handling::crash(error_handling::error_source::mod, "[_e_is_alive]",
-						"Entity reference should be std::weak_ptr<::entities::entity>* userdata");
+						"Entity reference should be entity userdata");
 
-				auto* e = reinterpret_cast<std::weak_ptr<::entities::entity>*>(luaL_checkudata(L, 1, "entity"));
+				auto* e = reinterpret_cast<::entities::entity_handle*>(luaL_checkudata(L, 1, "entity"));
 				luaL_argcheck(L, e != NULL, 1, "Entity reference expected");
 
-				lua_pushboolean(L, !e->expired());
+				auto entity = common::entity_registry->get(*e);
+				lua_pushboolean(L, entity != nullptr && !entity->is_kill_queued());
 					
 				return 1;
 			}
@@ -54,7 +57,10 @@ namespace behaviors
 				lua_remove(L, 1);
 				int args = luaL_ref(L, LUA_REGISTRYINDEX);
 
-				auto& comps = e->get_components();
+				//behaviors are gathered first, as events can add or kill components
+				std::vector<::entities::components::behavior*> behaviors;
+				e->for_each_component<::entities::components::behavior>(
+					[&](::entities::components::behavior* behavior) { behaviors.push_back(behavior); });
 				std::string event_name = "event_";
 				event_name += name;
 
@@ -63,20 +69,16 @@ namespace behaviors
 				int result_table = luaL_ref(L, LUA_REGISTRYINDEX);
 
 				int counter = 1;
-				for (auto& comp : comps)
+				for (auto& behavior : behaviors)
 				{
-					auto behavior = dynamic_cast<::entities::components::behavior*>(comp);
-					if (behavior != nullptr)
-					{
-						behavior->call_custom_function(event_name, args);
-						lua_rawgeti(L, LUA_REGISTRYINDEX, result_table);
-						lua_pushinteger(L, counter);
-						lua_insert(L, -3);
-						lua_insert(L, -3);
-						lua_settable(L, -3);
-						lua_remove(L, -1);
-						counter++;
-					}
+					behavior->call_custom_function(event_name, args);
+					lua_rawgeti(L, LUA_REGISTRYINDEX, result_table);
+					lua_pushinteger(L, counter);
+					lua_insert(L, -3);
+					lua_insert(L, -3);
+					lua_settable(L, -3);
+					lua_remove(L, -1);
+					counter++;
 				}		
 
 				luaL_unref(L, LUA_REGISTRYINDEX, args);
@@ -116,7 +118,7 @@ namespace behaviors
 			{
 				auto e = load_entity(L, 1, "[_e_kill_component]");
 				uint32_t id = load_id(L, 2, "[_e_kill_component]", "Component");
-				e->kill_component(id);
+				common::world->get_commands().kill_component(e->get_handle(), id);
 				return 0;
 			}
 
@@ -131,7 +133,7 @@ namespace behaviors
 			{
 				auto e = load_entity(L, 1, "[_e_set_layer]");
 				int layer = static_cast<int>(lua_tointeger(L, 2));
-				e->layer = layer;
+				common::world->get_commands().set_layer(e->get_handle(), static_cast<uint8_t>(layer));
 				return 0;
 			}
 
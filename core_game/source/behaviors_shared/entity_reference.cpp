@@ -5,18 +5,32 @@
 using namespace behaviors;
 using namespace lua_shared;
 
-int entity_reference_destructor(lua_State* L)
+void entity_reference::push(lua_State* L, ::entities::entity_handle entity)
 {
-	std::weak_ptr<::entities::entity>* e
-		= reinterpret_cast<std::weak_ptr<::entities::entity>*>(luaL_checkudata(L, -1, "entity"));
-	e->reset();
-	return 0;
+	auto e = common::entity_registry->get(entity);
+	if (e != nullptr && e->lua_reference != LUA_NOREF)
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, e->lua_reference);
+		return;
+	}
+
+	//handle is trivially destructible, so userdata needs no __gc
+	auto* data = reinterpret_cast<::entities::entity_handle*>(lua_newuserdata(L, sizeof(entity)));
+	*data = entity;
+	luaL_getmetatable(L, "entity");
+	lua_setmetatable(L, -2);
+
+	//dead entities can't be cached, their references are collected as before
+	if (e == nullptr)
+		return;
+	lua_pushvalue(L, -1);
+	e->lua_reference = luaL_ref(L, LUA_REGISTRYINDEX);
 }
 
-static const luaL_Reg entity_ref_metamehods[] = {
-	  {"__gc", entity_reference_destructor},
-	  {NULL, NULL}
-};
+void entity_reference::release(lua_State* L, int reference)
+{
+	luaL_unref(L, LUA_REGISTRYINDEX, reference);
+}
 
 void entity_reference::register_shared(lua_State* L)
 {
@@ -25,7 +39,5 @@ void entity_reference::register_shared(lua_State* L)
     lua_pushvalue(L, -2);
     lua_settable(L, -3);
 
-    luaL_setfuncs(L, entity_ref_metamehods, 0);
-
     lua_remove(L, -1);
 }
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include "source/entities/entity_registry.h"
+
 struct lua_State;
 
 namespace behaviors
@@ -7,6 +9,17 @@ namespace behaviors
 		namespace entity_reference
 		{
 			void register_shared(lua_State* L);
+			/*
+				push
+				pushes entity reference userdata on the stack, userdata holds the entity handle
+				userdata of an alive entity is created once and reused by the later pushes
+			*/
+			void push(lua_State* L, ::entities::entity_handle entity);
+			/*
+				release
+				frees the cached userdata reference of the entity
+			*/
+			void release(lua_State* L, int reference);
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "events_functions.h"
+
+#include "utilities.h"
+
+#include "source/common/common.h"
+#include "source/behaviors/behaviors_manager.h"
+#include "source/events/event_bus.h"
+
+namespace behaviors
+{
+	namespace lua_shared
+	{
+		namespace events
+		{
+			int _ev_subscribe(lua_State* L)
+			{
+				uint32_t channel = load_id(L, 1, "[_ev_subscribe]", "Channel");
+				if (!lua_isfunction(L, 2))
+					error_handling::crash(error_handling::error_source::mod, "[_ev_subscribe]", "Callback should be a function");
+				if (common::behaviors_manager->get_current_frame() == nullptr)
+					error_handling::crash(error_handling::error_source::mod, "[_ev_subscribe]",
+						"Subscriptions can be made only during behavior or scene calls");
+
+				::entities::entity_handle source;
+				bool has_source = !lua_isnoneornil(L, 3);
+				if (has_source)
+					source = load_entity(L, 3, "[_ev_subscribe]")->get_handle();
+
+				lua_pushvalue(L, 2);
+				int callback = luaL_ref(L, LUA_REGISTRYINDEX);
+				uint64_t id = common::event_bus->subscribe(channel, callback, source, has_source);
+				lua_pushinteger(L, static_cast<lua_Integer>(id));
+				return 1;
+			}
+
+			int _ev_unsubscribe(lua_State* L)
+			{
+				if (!lua_isinteger(L, 1))
+					error_handling::crash(error_handling::error_source::mod, "[_ev_unsubscribe]", "Subscription id should be an integer");
+				common::event_bus->unsubscribe(static_cast<uint64_t>(lua_tointeger(L, 1)));
+				return 0;
+			}
+
+			int _ev_emit(lua_State* L)
+			{
+				uint32_t channel = load_id(L, 1, "[_ev_emit]", "Channel");
+
+				::entities::entity_handle source;
+				if (!lua_isnoneornil(L, 3))
+					source = load_entity(L, 3, "[_ev_emit]")->get_handle();
+
+				lua_pushvalue(L, 2);
+				int payload = luaL_ref(L, LUA_REGISTRYINDEX);
+				common::event_bus->emit_custom(channel, payload, source);
+				return 0;
+			}
+
+			void register_shared(lua_State* L)
+			{
+				lua_register(L, "_ev_subscribe", _ev_subscribe);
+				lua_register(L, "_ev_unsubscribe", _ev_unsubscribe);
+				lua_register(L, "_ev_emit", _ev_emit);
+			}
+		}
+	}
+}
@@ -0,0 +1,178 @@
+#include "profiler_functions.h"
+
+#include "utilities.h"
+
+#include "source/common/common.h"
+#include "source/behaviors/behaviors_manager.h"
+#include "source/physics/collision_solver.h"
+#include "source/physics/dynamics_manager.h"
+#include "source/filesystem/mounts.h"
+#include "source/mods/mods_manager.h"
+
+#include <algorithm>
+
+namespace behaviors
+{
+	namespace lua_shared
+	{
+		namespace profiler
+		{
+			int _pr_set_frame_budget(lua_State* L)
+			{
+				if (!lua_isnumber(L, 1) || lua_tonumber(L, 1) < 0)
+					error_handling::crash(error_handling::error_source::mod, "[_pr_set_frame_budget]",
+						"Budget should be a non-negative number of milliseconds");
+				common::behaviors_manager->set_frame_budget(lua_tonumber(L, 1));
+				return 0;
+			}
+
+			int _pr_set_instructions_limit(lua_State* L)
+			{
+				if (!lua_isinteger(L, 1) || lua_tointeger(L, 1) < 0)
+					error_handling::crash(error_handling::error_source::mod, "[_pr_set_instructions_limit]",
+						"Limit should be a non-negative integer");
+				common::behaviors_manager->set_instructions_limit(static_cast<uint64_t>(lua_tointeger(L, 1)));
+				return 0;
+			}
+
+			int _pr_get_behaviors_stats(lua_State* L)
+			{
+				size_t amount = 10;
+				if (lua_isinteger(L, 1) && lua_tointeger(L, 1) > 0)
+					amount = static_cast<size_t>(lua_tointeger(L, 1));
+
+				auto stats = common::behaviors_manager->get_most_expensive_behaviors(amount);
+
+				lua_createtable(L, static_cast<int>(stats.size()), 0);
+				lua_Integer index = 1;
+				for (auto& behavior : stats)
+				{
+					lua_createtable(L, 0, 4);
+					push_string_to_table(L, "path", behavior.first.c_str());
+					push_number_to_table(L, "calls", static_cast<float>(behavior.second.calls));
+					push_number_to_table(L, "time", static_cast<float>(behavior.second.seconds * 1000.0));
+					push_number_to_table(L, "instructions", static_cast<float>(behavior.second.instructions));
+					lua_rawseti(L, -2, index++);
+				}
+				return 1;
+			}
+
+			int _pr_reset_behaviors_stats(lua_State* L)
+			{
+				common::behaviors_manager->reset_behaviors_stats();
+				return 0;
+			}
+
+			int _pr_get_lua_memory(lua_State* L)
+			{
+				auto& stats = common::behaviors_manager->get_memory_stats();
+				lua_createtable(L, 0, 6);
+				push_number_to_table(L, "allocated", static_cast<float>(stats.allocated));
+				push_number_to_table(L, "peak_allocated", static_cast<float>(stats.peak_allocated));
+				push_number_to_table(L, "pooled", static_cast<float>(stats.pooled));
+				push_number_to_table(L, "allocations", static_cast<float>(stats.allocations));
+				push_number_to_table(L, "large_allocations", static_cast<float>(stats.large_allocations));
+				push_number_to_table(L, "refused_allocations", static_cast<float>(stats.refused_allocations));
+				return 1;
+			}
+
+			int _pr_get_physics_memory(lua_State* L)
+			{
+				auto& colliders = common::collision_solver->get_pool();
+				auto& dynamics = common::dynamics_manager->get_pool();
+				lua_createtable(L, 0, 4);
+				push_number_to_table(L, "colliders", static_cast<float>(colliders.size()));
+				push_number_to_table(L, "colliders_bytes", static_cast<float>(colliders.get_memory_usage()));
+				push_number_to_table(L, "dynamics", static_cast<float>(dynamics.size()));
+				push_number_to_table(L, "dynamics_bytes", static_cast<float>(dynamics.get_memory_usage()));
+				return 1;
+			}
+
+			int _pr_get_dynamics_stats(lua_State* L)
+			{
+				auto& dynamics = common::dynamics_manager->get_pool();
+				lua_createtable(L, 0, 2);
+				push_number_to_table(L, "awake", static_cast<float>(dynamics.size() - dynamics.sleeping_count));
+				push_number_to_table(L, "sleeping", static_cast<float>(dynamics.sleeping_count));
+				return 1;
+			}
+
+			int _pr_get_collision_stats(lua_State* L)
+			{
+				auto stats = common::collision_solver->get_stats();
+				lua_createtable(L, 0, 3);
+				push_number_to_table(L, "candidates", static_cast<float>(stats.candidates));
+				push_number_to_table(L, "narrowphase_tests", static_cast<float>(stats.narrowphase_tests));
+				push_number_to_table(L, "narrowphase_ratio", stats.candidates == 0 ? 0.0f :
+					static_cast<float>(stats.narrowphase_tests) / static_cast<float>(stats.candidates));
+				return 1;
+			}
+
+			int _pr_reset_collision_stats(lua_State* L)
+			{
+				common::collision_solver->reset_stats();
+				return 0;
+			}
+
+			int _pr_get_files_stats(lua_State* L)
+			{
+				size_t amount = 10;
+				if (lua_isinteger(L, 1) && lua_tointeger(L, 1) > 0)
+					amount = static_cast<size_t>(lua_tointeger(L, 1));
+
+				auto stats = filesystem::get_files_stats();
+				amount = std::min(amount, stats.size());
+				std::partial_sort(stats.begin(), stats.begin() + amount, stats.end(), [](const auto& a, const auto& b)
+					{
+						return a.second.open_nanoseconds + a.second.read_nanoseconds > b.second.open_nanoseconds + b.second.read_nanoseconds;
+					});
+
+				lua_createtable(L, static_cast<int>(amount), 0);
+				for (size_t i = 0; i < amount; i++)
+				{
+					auto& file = stats[i];
+					lua_createtable(L, 0, 6);
+					push_string_to_table(L, "path", file.first.c_str());
+					push_number_to_table(L, "opens", static_cast<float>(file.second.opens));
+					push_number_to_table(L, "reads", static_cast<float>(file.second.reads));
+					push_number_to_table(L, "bytes", static_cast<float>(file.second.bytes_read));
+					push_number_to_table(L, "open_time", static_cast<float>(file.second.open_nanoseconds / 1000000.0));
+					push_number_to_table(L, "read_time", static_cast<float>(file.second.read_nanoseconds / 1000000.0));
+					lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+				}
+				return 1;
+			}
+
+			int _pr_reset_files_stats(lua_State* L)
+			{
+				filesystem::reset_files_stats();
+				return 0;
+			}
+
+			int _pr_get_preload_time(lua_State* L)
+			{
+				auto& stats = common::mods_manager->get_preload_stats();
+				lua_createtable(L, 0, 2);
+				push_number_to_table(L, "assets", static_cast<float>(stats.assets));
+				push_number_to_table(L, "time", static_cast<float>(stats.milliseconds));
+				return 1;
+			}
+
+			void register_shared(lua_State* L)
+			{
+				lua_register(L, "_pr_set_frame_budget", _pr_set_frame_budget);
+				lua_register(L, "_pr_set_instructions_limit", _pr_set_instructions_limit);
+				lua_register(L, "_pr_get_behaviors_stats", _pr_get_behaviors_stats);
+				lua_register(L, "_pr_reset_behaviors_stats", _pr_reset_behaviors_stats);
+				lua_register(L, "_pr_get_lua_memory", _pr_get_lua_memory);
+				lua_register(L, "_pr_get_physics_memory", _pr_get_physics_memory);
+				lua_register(L, "_pr_get_dynamics_stats", _pr_get_dynamics_stats);
+				lua_register(L, "_pr_get_collision_stats", _pr_get_collision_stats);
+				lua_register(L, "_pr_reset_collision_stats", _pr_reset_collision_stats);
+				lua_register(L, "_pr_get_files_stats", _pr_get_files_stats);
+				lua_register(L, "_pr_reset_files_stats", _pr_reset_files_stats);
+				lua_register(L, "_pr_get_preload_time", _pr_get_preload_time);
+			}
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#include "task_functions.h"
+
+#include "utilities.h"
+
+#include "source/common/common.h"
+#include "source/behaviors/behaviors_manager.h"
+
+namespace behaviors
+{
+	namespace lua_shared
+	{
+		namespace task
+		{
+			static void assert_in_task(lua_State* L, const char* function)
+			{
+				if (!common::behaviors_manager->is_in_task(L))
+					error_handling::crash(error_handling::error_source::mod, function,
+						"Waiting is possible only inside a task started with _t_start");
+			}
+
+			int _t_start(lua_State* L)
+			{
+				if (!lua_isfunction(L, 1))
+					error_handling::crash(error_handling::error_source::mod, "[_t_start]", "Task should be a function");
+				common::behaviors_manager->start_task(L, lua_gettop(L) - 1);
+				return 0;
+			}
+
+			int _t_wait(lua_State* L)
+			{
+				assert_in_task(L, "[_t_wait]");
+				if (!lua_isnumber(L, 1) || lua_tonumber(L, 1) < 0)
+					error_handling::crash(error_handling::error_source::mod, "[_t_wait]",
+						"Time should be a non-negative number of seconds");
+				common::behaviors_manager->wait_seconds(lua_tonumber(L, 1));
+				return lua_yield(L, 0);
+			}
+
+			int _t_wait_frames(lua_State* L)
+			{
+				assert_in_task(L, "[_t_wait_frames]");
+				lua_Integer frames = 1;
+				if (lua_isinteger(L, 1))
+					frames = lua_tointeger(L, 1);
+				if (frames < 1)
+					error_handling::crash(error_handling::error_source::mod, "[_t_wait_frames]",
+						"Frames amount should be a positive integer");
+				common::behaviors_manager->wait_frames(static_cast<uint64_t>(frames));
+				return lua_yield(L, 0);
+			}
+
+			int _t_wait_until(lua_State* L)
+			{
+				assert_in_task(L, "[_t_wait_until]");
+				if (!lua_isstring(L, 1))
+					error_handling::crash(error_handling::error_source::mod, "[_t_wait_until]", "Signal should be a string");
+				common::behaviors_manager->wait_signal(lua_tostring(L, 1));
+				return lua_yield(L, 0);
+			}
+
+			int _t_signal(lua_State* L)
+			{
+				if (!lua_isstring(L, 1))
+					error_handling::crash(error_handling::error_source::mod, "[_t_signal]", "Signal should be a string");
+				common::behaviors_manager->signal(lua_tostring(L, 1));
+				return 0;
+			}
+
+			void register_shared(lua_State* L)
+			{
+				lua_register(L, "_t_start", _t_start);
+				lua_register(L, "_t_wait", _t_wait);
+				lua_register(L, "_t_wait_frames", _t_wait_frames);
+				lua_register(L, "_t_wait_until", _t_wait_until);
+				lua_register(L, "_t_signal", _t_signal);
+			}
+		}
+	}
+}
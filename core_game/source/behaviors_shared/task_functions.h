@@ -0,0 +1,12 @@
+struct lua_State;
+
+namespace behaviors
+{
+	namespace lua_shared
+	{
+		namespace task
+		{
+			void register_shared(lua_State* L);
+		}
+	}
+}
@@ -19,30 +19,30 @@ extern "C"
 #include "source/entities/entity.h"
 #include "source/entities/component.h"
 
+#include "entity_reference.h"
+
 #include "source/utilities/hash_string.h"
 
 #include "source/rendering/render_config.h"
 
-inline void push_entity(lua_State* L, std::weak_ptr<::entities::entity>& entity)
+inline void push_entity(lua_State* L, ::entities::entity_handle entity)
 {
-	auto* data = (std::weak_ptr<::entities::entity>*)(lua_newuserdata(L, sizeof(entity)));
-	new(data) std::weak_ptr<::entities::entity>(entity);
-	luaL_getmetatable(L, "entity");
-	lua_setmetatable(L, -2);
+	behaviors::lua_shared::entity_reference::push(L, entity);
 }
 
-inline std::shared_ptr<::entities::entity> load_entity(lua_State* L, int arg_id, const std::string parent_function)
+inline ::entities::entity* load_entity(lua_State* L, int arg_id, const std::string parent_function)
 {
 	if (!lua_isuserdata(L, arg_id))
 		error_handling::crash(error_handling::error_source::mod, parent_function,
-			"Entity reference should be std::weak_ptr<::entities::entity>* userdata");
+			"Entity reference should be entity userdata");
 
-	auto* ptr = reinterpret_cast<std::weak_ptr<::entities::entity>*>(luaL_checkudata(L, arg_id, "entity"));
+	auto* ptr = reinterpret_cast<::entities::entity_handle*>(luaL_checkudata(L, arg_id, "entity"));
 	luaL_argcheck(L, ptr != nullptr, arg_id, "Entity reference expected");
 
-	if (ptr->expired())
+	auto e = common::entity_registry->get(*ptr);
+	if (e == nullptr)
 		error_handling::crash(error_handling::error_source::mod, parent_function, "Trying to perform operations on dead entity.");
-	return ptr->lock();
+	return e;
 }
 
 inline uint32_t load_id(lua_State* L, int arg_id, std::string parent_function, const std::string id_of_what)
@@ -68,15 +68,15 @@ inline comp_class* load_component(lua_State* L, const std::string parent_functio
 {
 	auto e = load_entity(L, entity_ptr_pos, parent_function);
 	uint32_t comp = load_id(L, component_id_pos, parent_function, "Component");
-	auto component = e->get_component(comp);
-	if (component == nullptr)
+	auto casted = e->template get_component<comp_class>(comp);
+	if (casted != nullptr)
+		return casted;
+	if (e->get_component(comp) == nullptr)
 		error_handling::crash(error_handling::error_source::mod, parent_function, 
 			"Entity does not contain component with tag: " + std::to_string(comp));
-	auto casted = dynamic_cast<comp_class*>(component);
-	if (casted == nullptr)
-		error_handling::crash(error_handling::error_source::mod, parent_function, 
-			"Component: " + std::to_string(comp) + " is not of the type you try to operate on");
-	return casted;
+	error_handling::crash(error_handling::error_source::mod, parent_function, 
+		"Component: " + std::to_string(comp) + " is not of the type you try to operate on");
+	return nullptr;
 }
 
 inline rendering::render_config load_render_config(lua_State* L, int arg_id, const std::string parent_function)
@@ -246,7 +246,7 @@ inline void push_string_to_table(lua_State* L, const char* name, const char* val
 	lua_settable(L, -3);
 }
 
-inline void push_entity_to_table(lua_State* L, const char* name, std::weak_ptr<::entities::entity> value)
+inline void push_entity_to_table(lua_State* L, const char* name, ::entities::entity_handle value)
 {
 	lua_pushstring(L, name);
 	push_entity(L, value);
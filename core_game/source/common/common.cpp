@@ -5,12 +5,14 @@
 #include "source/audio/audio_manager.h"
 #include "source/assets/assets_manager.h"
 #include "source/entities/world.h"
+#include "source/entities/entity_registry.h"
 #include "source/behaviors/behaviors_manager.h"
 #include "source/input/input_manager.h"
 #include "source/window/window_manager.h"
 #include "source/physics/collision_solver.h"
 #include "source/physics/dynamics_manager.h"
 #include "source/mods/mods_manager.h"
+#include "source/events/event_bus.h"
 
 namespace common
 {
@@ -26,6 +28,8 @@ namespace common
 	std::unique_ptr<rendering::flipbooks_manager> flipbooks_manager = std::make_unique<rendering::flipbooks_manager>();
 	std::unique_ptr<audio::audio_manager> audio_manager = std::make_unique<audio::audio_manager>();;
 	std::unique_ptr<assets::assets_manager> assets_manager = std::make_unique<assets::assets_manager>();
+	//registry is defined before the world, so it outlives entities of the world
+	std::unique_ptr<entities::entity_registry> entity_registry = std::make_unique<entities::entity_registry>();
 	std::unique_ptr<entities::world> world = std::make_unique<entities::world>();
 	std::unique_ptr<behaviors::behaviors_manager> behaviors_manager = std::make_unique<behaviors::behaviors_manager>();
 	std::unique_ptr<input::input_manager> input_mananger = std::make_unique<input::input_manager>();
@@ -33,4 +37,5 @@ namespace common
 	std::unique_ptr<physics::collision_solver> collision_solver = std::make_unique<physics::collision_solver>();
 	std::unique_ptr<physics::dynamics_manager> dynamics_manager = std::make_unique<physics::dynamics_manager>();
 	std::unique_ptr<mods::mods_manager> mods_manager = std::make_unique<mods::mods_manager>();
+	std::unique_ptr<events::event_bus> event_bus = std::make_unique<events::event_bus>();
 }
\ No newline at end of file
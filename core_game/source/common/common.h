@@ -21,6 +21,7 @@ namespace assets
 namespace entities
 {
 	class world;
+	class entity_registry;
 }
 
 namespace behaviors
@@ -49,6 +50,11 @@ namespace mods
 	class mods_manager;
 }
 
+namespace events
+{
+	class event_bus;
+}
+
 namespace common
 {
 	enum class program_state
@@ -80,6 +86,7 @@ namespace common
 	extern std::unique_ptr<rendering::renderer> renderer;
 	extern std::unique_ptr<audio::audio_manager> audio_manager;
 	extern std::unique_ptr<assets::assets_manager> assets_manager;
+	extern std::unique_ptr<entities::entity_registry> entity_registry;
 	extern std::unique_ptr<entities::world> world;
 	extern std::unique_ptr<behaviors::behaviors_manager> behaviors_manager;
 	extern std::unique_ptr<window::window_manager> window_manager;
@@ -87,4 +94,5 @@ namespace common
 	extern std::unique_ptr<physics::collision_solver> collision_solver;
 	extern std::unique_ptr<physics::dynamics_manager> dynamics_manager;
 	extern std::unique_ptr<mods::mods_manager> mods_manager;
+	extern std::unique_ptr<events::event_bus> event_bus;
 }
\ No newline at end of file
@@ -13,6 +13,19 @@
 */
 static bool pending_unload = false;
 
+//count of alive recoverable_scope objects
+static int recoverable_depth = 0;
+
+error_handling::recoverable_scope::recoverable_scope()
+{
+	recoverable_depth++;
+}
+
+error_handling::recoverable_scope::~recoverable_scope()
+{
+	recoverable_depth--;
+}
+
 void error_handling::show_crash_info(std::string text)
 {
 	if (pending_unload)
@@ -46,6 +59,9 @@ void error_handling::crash(error_source source, std::string function, std::strin
 	full_text.push_back('\n');
 	full_text.append(text.c_str());
 
+	if (recoverable_depth > 0)
+		throw recoverable_error(full_text);
+
 	show_crash_info(full_text);
 
 	pending_unload = true;
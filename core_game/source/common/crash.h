@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <stdexcept>
 
 namespace error_handling
 {
@@ -14,4 +15,27 @@ namespace error_handling
 	*/
 	void crash(error_source source, std::string function, std::string text);
 	void show_crash_info(std::string text);
+
+	/*
+		recoverable_error
+		thrown by crash instead of closing the game, while a recoverable_scope is alive
+	*/
+	struct recoverable_error : public std::runtime_error
+	{
+		recoverable_error(const std::string& text) : std::runtime_error(text) {};
+	};
+
+	/*
+		recoverable_scope
+		makes crash calls made during its lifetime throw recoverable_error
+		used where the failure can be reported and the game can go on, like hot reloading
+	*/
+	class recoverable_scope
+	{
+	public:
+		recoverable_scope();
+		~recoverable_scope();
+		recoverable_scope(const recoverable_scope&) = delete;
+		recoverable_scope& operator=(const recoverable_scope&) = delete;
+	};
 }
\ No newline at end of file
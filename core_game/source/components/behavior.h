@@ -11,6 +11,11 @@ namespace assets
 	struct behavior;
 }
 
+namespace behaviors
+{
+	class behaviors_manager;
+}
+
 namespace entities
 {
 	namespace components
@@ -22,8 +27,16 @@ namespace entities
 		*/
 		class behavior : virtual public entities::component
 		{	
+		friend behaviors::behaviors_manager;
+		public:
+			static constexpr component_type type_id = component_type::behavior;
 		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); };
 			std::shared_ptr<behaviors::database> database;
+			//time of the on_update calls skipped by the frame budget, added to the next delta_time
+			double deferred_time = 0;
+			//index in the behaviors manager
+			size_t manager_index = 0;
 		public:
 			std::shared_ptr<assets::behavior> behavior_asset;
 			behavior(uint32_t _id, std::weak_ptr<assets::behavior> _behavior_asset);
@@ -32,7 +45,7 @@ namespace entities
 				call_function
 				calls function on the behavior
 			*/
-			void call_function(behaviors::functions func, std::weak_ptr<entities::entity> other = {});
+			void call_function(behaviors::functions func, entities::entity_handle other = {});
 			/*
 				call_custom_function
 				calls function of given name on the behavior
@@ -13,7 +13,10 @@ namespace entities
 		*/
 		class camera : virtual public entities::component
 		{
+		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); };
 		public:
+			static constexpr component_type type_id = component_type::camera;
 			camera(uint32_t _id, float _ortho_width) : ortho_width(_ortho_width), component(_id) {}
 			~camera();
 			/*
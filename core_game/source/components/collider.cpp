@@ -3,6 +3,9 @@
 
 #include "source/common/common.h"
 #include "source/physics/collision_solver.h"
+#include "source/physics/dynamics_manager.h"
+
+#include "include/glm/glm.hpp"
 
 glm::vec2 entities::components::collider::get_world_pos()
 {
@@ -14,6 +17,36 @@ int entities::components::collider::get_layer()
 	return owner->layer + layer_offset;
 }
 
+void entities::components::collider::refresh()
+{
+	if (pool_index != npos)
+		common::collision_solver->update_collider(this);
+}
+
+void entities::components::collider::set_preset(physics::collision_preset new_preset)
+{
+	preset = new_preset;
+	refresh();
+}
+
+void entities::components::collider::set_layer_offset(int new_layer_offset)
+{
+	layer_offset = new_layer_offset;
+	refresh();
+}
+
+void entities::components::collider::set_entity_offset(glm::vec2 new_entity_offset)
+{
+	entity_offset = new_entity_offset;
+	refresh();
+}
+
+void entities::components::collider::set_extend(glm::vec2 new_extend)
+{
+	extend = new_extend;
+	refresh();
+}
+
 void entities::components::collider::on_attach()
 {
 	common::collision_solver->register_collider(this);
@@ -21,5 +54,14 @@ void entities::components::collider::on_attach()
 
 entities::components::collider::~collider()
 {
+	if (pool_index == npos)
+		return;
 	common::collision_solver->unregister_collider(this);
-}
\ No newline at end of file
+	if (!wake_on_destroy)
+		return;
+
+	//Bodies resting on the collider fall again
+	glm::vec2 half = glm::abs(extend) / 2.0f;
+	glm::vec2 margin = { 0.1f, 0.1f };
+	common::dynamics_manager->wake_in_box(get_world_pos() - half - margin, get_world_pos() + half + margin);
+}
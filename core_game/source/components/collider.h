@@ -3,6 +3,14 @@
 #include "include/glm/vec2.hpp"
 #include "source/physics/collision.h"
 
+#include <cstddef>
+#include <cstdint>
+
+namespace physics
+{
+	class collision_solver;
+}
+
 namespace entities
 {
 	namespace components
@@ -13,15 +21,35 @@ namespace entities
 			collider
 			component that links the collision detection subsystem with game logic
 			collider makes body collide / overlap with other bodies containing colliders
+			registered collider mirrors its state into the collision solver pool
 		*/
 		class collider : virtual public component
 		{
+		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); };
+			virtual void on_owner_changed() override { refresh(); };
+		public:
+			static constexpr component_type type_id = component_type::collider;
+			static constexpr size_t npos = SIZE_MAX;
+		private:
 			friend tilemap;
+			friend physics::collision_solver;
 			void initialize_in_tilemap(entities::entity* _owner)
 			{
 				owner = _owner;
 			}
-		public:
+
+			/*
+				index in the collision solver pool, npos if the collider is not registered
+			*/
+			size_t pool_index = npos;
+
+			/*
+				bodies overlapping the collider are woken when it's destroyed
+				tilemap disables it and wakes bodies over its whole bounds once
+			*/
+			bool wake_on_destroy = true;
+
 			/*
 				flag that determine how should collider interact with other colliders
 			*/
@@ -31,12 +59,6 @@ namespace entities
 				offsets collider from entity layer
 			*/
 			int layer_offset = 0;
-			
-			/*
-				get_layer
-				returns collider layer
-			*/
-			int get_layer();
 
 			/*
 				entity-relative location
@@ -44,21 +66,44 @@ namespace entities
 			glm::vec2 entity_offset = { 0,0 };
 
 			/*
-				returns collider world space location
+				collider box extend
 			*/
-			glm::vec2 get_world_pos();
+			glm::vec2 extend;
 
 			/*
-				collider box extend
+				refresh
+				updates collider entry in the collision solver pool
 			*/
-			glm::vec2 extend;
+			void refresh();
+		public:
+			physics::collision_preset get_preset() { return preset; }
+			void set_preset(physics::collision_preset new_preset);
+
+			int get_layer_offset() { return layer_offset; }
+			void set_layer_offset(int new_layer_offset);
+
+			const glm::vec2& get_entity_offset() { return entity_offset; }
+			void set_entity_offset(glm::vec2 new_entity_offset);
+
+			const glm::vec2& get_extend() { return extend; }
+			void set_extend(glm::vec2 new_extend);
+			
+			/*
+				get_layer
+				returns collider layer
+			*/
+			int get_layer();
+
+			/*
+				returns collider world space location
+			*/
+			glm::vec2 get_world_pos();
 
 			collider(uint32_t _id, physics::collision_preset _preset, glm::vec2 _extend) 
 				: component(_id), extend(_extend), preset(_preset) {};
 			~collider();
 
 			virtual void on_attach();
-		private:
 		};
 	}
-}
\ No newline at end of file
+}
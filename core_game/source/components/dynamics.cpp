@@ -10,7 +10,7 @@
 using namespace entities;
 using namespace components;
 
-dynamics::dynamics(uint32_t _id) : component(_id), gravity_enabled(!common::top_down)
+dynamics::dynamics(uint32_t _id) : component(_id)
 {
 	common::dynamics_manager->register_dynamics(this);
 }
@@ -20,37 +20,26 @@ dynamics::~dynamics()
 	common::dynamics_manager->unregister_dynamics(this);
 }
 
-void dynamics::apply_forces()
+physics::dynamics_pool& dynamics::pool()
 {
-	//Constrain Velocity
-	if (glm::length(velocity) > maximum_velocity && use_maximum_velocity)
-		velocity = glm::normalize(velocity) * maximum_velocity;
-
-	if (common::top_down)
-		velocity -= velocity * float(drag * common::delta_time) * common::physics_time_dilation_mod;
-	else
-		velocity.x -= velocity.x * float(drag * common::delta_time) * common::physics_time_dilation_mod;
-
-	if (glm::length(frame_force) == 0)
-	{
-		if (std::abs(velocity.x) < 0.3f)
-			velocity.x = 0;
-
-		if (std::abs(velocity.y) < 0.3f)
-			velocity.y = 0;
-	}
+	return common::dynamics_manager->get_pool();
+}
 
-	if (gravity_enabled)
-	{
-		frame_force.y -= common::gravitational_acceleration;
-	}
+bool dynamics::get_flag(uint8_t flag)
+{
+	return (pool().flags[pool_index] & flag) != 0;
+}
 
-	velocity += (frame_force / mass) * float(common::delta_time) * common::physics_time_dilation_mod;
-	frame_force = { 0, 0 };
+void dynamics::set_flag(uint8_t flag, bool value)
+{
+	auto& flags = pool().flags[pool_index];
+	flags = static_cast<uint8_t>(value ? (flags | flag) : (flags & ~flag));
 }
 
 void dynamics::collide_event(glm::vec2& normal)
 {
+	auto& velocity = pool().velocities[pool_index];
+
 	if (velocity.x > 0 && normal.x < 0) velocity.x = 0;
 	else if (velocity.x < 0 && normal.x > 0) velocity.x = 0;
 
@@ -58,12 +47,91 @@ void dynamics::collide_event(glm::vec2& normal)
 	else if (velocity.y < 0 && normal.y > 0)
 	{
 		velocity.y = 0;
-		grouned = true;
+		set_flag(physics::dynamics_pool::grounded, true);
 	}
 }
 
-void dynamics::sweep()
+bool dynamics::get_grounded()
+{
+	return get_flag(physics::dynamics_pool::grounded);
+}
+
+void dynamics::wake_up()
+{
+	common::dynamics_manager->wake(this);
+}
+
+bool dynamics::get_sleeping()
+{
+	return get_flag(physics::dynamics_pool::sleeping);
+}
+
+void dynamics::add_force(glm::vec2 force)
+{
+	if (force.x != 0 || force.y != 0)
+		wake_up();
+	pool().forces[pool_index] += force;
+}
+
+void dynamics::set_velocity(glm::vec2 vel)
+{
+	if (vel.x != 0 || vel.y != 0)
+		wake_up();
+	pool().velocities[pool_index] = vel;
+}
+
+glm::vec2 dynamics::get_velocity()
+{
+	return pool().velocities[pool_index];
+}
+
+float dynamics::get_drag()
+{
+	return pool().drags[pool_index];
+}
+
+void dynamics::set_drag(float drag)
 {
-	apply_forces();
-	owner->sweep(owner->get_location() + velocity * float(common::delta_time) * common::physics_time_dilation_mod);
-}
\ No newline at end of file
+	pool().drags[pool_index] = drag;
+}
+
+float dynamics::get_mass()
+{
+	return pool().masses[pool_index];
+}
+
+void dynamics::set_mass(float mass)
+{
+	pool().masses[pool_index] = mass;
+}
+
+bool dynamics::get_use_maximum_velocity()
+{
+	return get_flag(physics::dynamics_pool::use_maximum_velocity);
+}
+
+void dynamics::set_use_maximum_velocity(bool use)
+{
+	set_flag(physics::dynamics_pool::use_maximum_velocity, use);
+}
+
+float dynamics::get_maximum_velocity()
+{
+	return pool().maximum_velocities[pool_index];
+}
+
+void dynamics::set_maximum_velocity(float velocity)
+{
+	pool().maximum_velocities[pool_index] = velocity;
+}
+
+bool dynamics::get_gravity_enabled()
+{
+	return get_flag(physics::dynamics_pool::gravity_enabled);
+}
+
+void dynamics::set_gravity_enabled(bool enabled)
+{
+	wake_up();
+	set_flag(physics::dynamics_pool::gravity_enabled, enabled);
+}
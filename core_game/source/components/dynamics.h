@@ -2,9 +2,12 @@
 #include "source/entities/component.h"
 #include "include/glm/vec2.hpp"
 
+#include <cstddef>
+
 namespace physics
 {
 	class dynamics_manager;
+	struct dynamics_pool;
 }
 
 namespace entities
@@ -14,50 +17,59 @@ namespace entities
 		/*
 			dynamics
 			component that automates forces, for quicker development
+			state of the body is stored in the dynamics manager pool
 		*/
 		class dynamics : virtual public component
 		{
+		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); };
+		public:
+			static constexpr component_type type_id = component_type::dynamics;
 		private:
 			friend entities::entity;
 			friend physics::dynamics_manager;
 
-			glm::vec2 velocity{};
-			glm::vec2 frame_force{};
-			bool grouned = false;
-			void apply_forces();
+			//index in the dynamics pool, updated by the manager when bodies are moved
+			size_t pool_index = 0;
+			physics::dynamics_pool& pool();
+			bool get_flag(uint8_t flag);
+			void set_flag(uint8_t flag, bool value);
 			void collide_event(glm::vec2& normal);
+		protected:
+			//moved body may have lost what it was resting on
+			virtual void on_owner_changed() override { wake_up(); };
 		public:
-			bool  use_maximum_velocity = false;
-			float maximum_velocity = 0.0f;
-			float drag = 0.7f;
-			float mass = 1.0f;
-			bool  gravity_enabled;
-
 			dynamics(uint32_t _id);
 			~dynamics();
 
-			const bool& get_grounded() { return grouned; }
+			bool get_grounded();
+			/*
+				wake_up
+				body resting long enough falls asleep and isn't updated
+				it wakes on forces, velocity changes, moves and collisions with other bodies
+			*/
+			void wake_up();
+			bool get_sleeping();
 
-			void add_force(glm::vec2 force)
-			{
-				frame_force += force;
-			}
+			void add_force(glm::vec2 force);
 
-			void sweep();
+			void set_velocity(glm::vec2 vel);
+			glm::vec2 get_velocity();
 
-			const void set_velocity(glm::vec2 vel)
-			{
-				velocity = vel;
-			}
-
-			const glm::vec2& get_velocity() 
-			{ 
-				return velocity; 
-			};
+			float get_drag();
+			void set_drag(float drag);
+			float get_mass();
+			void set_mass(float mass);
+			bool get_use_maximum_velocity();
+			void set_use_maximum_velocity(bool use);
+			float get_maximum_velocity();
+			void set_maximum_velocity(float velocity);
+			bool get_gravity_enabled();
+			void set_gravity_enabled(bool enabled);
 			
 			virtual void on_attach() override
 			{
 			}
 		};
 	}
-}
\ No newline at end of file
+}
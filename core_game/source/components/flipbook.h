@@ -2,13 +2,26 @@
 #include "sprite.h"
 #include "source/assets/flipbook_asset.h"
 
+namespace rendering
+{
+	class flipbooks_manager;
+}
+
 namespace entities
 {
 	namespace components
 	{
 		class flipbook : virtual public sprite
 		{
+			friend rendering::flipbooks_manager;
+		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); sprite::expose_types(slots); };
+		public:
+			static constexpr component_type type_id = component_type::flipbook;
+		private:
 			uint32_t current_flipbook_animation;
+			//index in the flipbooks manager
+			size_t manager_index = 0;
 		public:
 			float playback_position = 0;
 			bool looping = true;
@@ -11,7 +11,10 @@ namespace entities
 		*/
 		class listener : virtual public entities::component
 		{
+		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); };
 		public:
+			static constexpr component_type type_id = component_type::listener;
 			listener(uint32_t id);
 			~listener();
 			virtual void on_attach() override;
@@ -22,6 +22,11 @@ namespace entities
 		*/
 		class mesh : virtual public entities::component
 		{
+		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); };
+			virtual void on_owner_changed() override { mark_pipeline_dirty(); };
+		public:
+			static constexpr component_type type_id = component_type::mesh;
 			friend entities::entity;
 			friend rendering::renderer;
 		protected:
@@ -30,6 +35,9 @@ namespace entities
 			bool visible = true;
 			glm::vec2 offset = { 0, 0 };
 			glm::vec2 scale = { 1, 1 };
+		private:
+			//index in the meshes of its pipeline, kept by the renderer
+			size_t render_index = 0;
 		public:
 			void set_visible(bool visiblity) { if (visible != visiblity) { visible = visiblity; mark_pipeline_dirty(); } }
 			bool get_visible() { return visible; }
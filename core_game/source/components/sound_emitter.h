@@ -12,7 +12,10 @@ namespace entities
 		*/
 		class sound_emitter : virtual public entities::component
 		{
+		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); };
 		public:
+			static constexpr component_type type_id = component_type::sound_emitter;
 			sound_emitter(uint32_t id);
 			~sound_emitter();
 			virtual void on_attach() override;
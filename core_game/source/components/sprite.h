@@ -8,6 +8,11 @@ namespace entities
 	{
 		class sprite : virtual public mesh, virtual public collider
 		{
+		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); mesh::expose_types(slots); collider::expose_types(slots); };
+			virtual void on_owner_changed() override { mesh::on_owner_changed(); collider::on_owner_changed(); };
+		public:
+			static constexpr component_type type_id = component_type::sprite;
 		protected:
 			rendering::render_config rc;
 			glm::vec2 sprite_extend;
@@ -12,6 +12,10 @@ namespace entities
 		*/
 		class static_mesh : virtual public entities::components::mesh
 		{
+		protected:
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); mesh::expose_types(slots); };
+		public:
+			static constexpr component_type type_id = component_type::static_mesh;
 		protected:
 			/*
 				all data required to draw the mesh
@@ -6,11 +6,14 @@
 #include "source/assets/rendering_config_asset.h"
 
 #include "source/rendering/renderer.h"
+#include "source/components/camera.h"
 #include "source/utilities/hash_string.h"
 
 #include "source/assets/shader_asset.h"
 #include "source/assets/mesh_asset.h"
 
+#include <cmath>
+
 using namespace entities;
 using namespace components;
 
@@ -38,43 +41,45 @@ tilemap::tilemap(
 void tilemap::pass_transformation(rendering::transformations_buffer_stream& tbi)
 {
 	int layer_counter = 0;
+	size_t chunk_index = 0;
 
 	float tile_x_size = static_cast<float>(tileset_asset->tile_width / common::pixels_per_world_unit);
 	float tile_y_size = static_cast<float>(tileset_asset->tile_width / common::pixels_per_world_unit);
 
+	//location of the bottom left tile of the map
+	float base_x = owner->get_location().x - static_cast<float>((float(tilemap_asset->width) / 2 - 0.5) * tile_x_size);
+	float base_y = owner->get_location().y - static_cast<float>((float(tilemap_asset->height) / 2 - 0.5) * tile_y_size);
+
 	for (auto& layer : tilemap_asset->layers)
 	{
-		float y_mod = static_cast<float>(- 1 * (float(tilemap_asset->height) / 2 - 0.5) * tile_y_size);
-		auto row = layer.end() - 1;
-
-		while (true)
+		for (auto& chunk : layer.chunks)
 		{
-			float x_mod = static_cast<float>(- 1 * (float(tilemap_asset->width) / 2 - 0.5) * tile_x_size);
-			for (auto& tile : *row)
+			if (!acquired_chunks.at(chunk_index++))
+				continue;
+
+			const uint32_t* tile = chunk.tiles.data();
+			for (unsigned int y = 0; y < chunk.height; y++)
 			{
-				if (tile == 0)
-				{
-					x_mod += tile_x_size;
-					continue;
-				}
+				int row = chunk.y + static_cast<int>(y) - tilemap_asset->origin_y;
+				float y_mod = (static_cast<int>(tilemap_asset->height) - 1 - row) * tile_y_size;
+				float x_mod = (chunk.x - tilemap_asset->origin_x) * tile_x_size;
 
-				tbi.put(owner->get_location().x + x_mod);
-				tbi.put(owner->get_location().y + y_mod);
+				for (unsigned int x = 0; x < chunk.width; x++, tile++, x_mod += tile_x_size)
+				{
+					if (*tile == 0)
+						continue;
 
-				tbi.put(tile_x_size);
-				tbi.put(tile_y_size);
+					tbi.put(base_x + x_mod);
+					tbi.put(base_y + y_mod);
 
-				tbi.put(owner->layer + layer_counter);
-				tbi.put(tile - 1);
+					tbi.put(tile_x_size);
+					tbi.put(tile_y_size);
 
-				x_mod += tile_x_size;
+					tbi.put(owner->layer + layer_counter);
+					tbi.put(static_cast<int>(*tile - 1));
+				}
 			}
-
-			y_mod += tile_y_size;
-			if (row == layer.begin())
-				break;
-			row--;
-		}	
+		}
 
 		layer_counter += 1 * layers_stride;
 	}
@@ -85,15 +90,122 @@ const rendering::render_config& tilemap::get_render_config()
 	return _config;
 }
 
+static std::vector<tilemap*> streamed_tilemaps;
+
 void tilemap::on_attach()
 {
 	common::renderer->register_mesh_component(this);
-	build_colliders();
+
+	size_t chunks_count = 0;
+	for (auto& layer : tilemap_asset->layers)
+		chunks_count += layer.chunks.size();
+	acquired_chunks.assign(chunks_count, false);
+	chunk_colliders.resize(chunks_count);
+
+	if (tilemap_asset->infinite)
+	{
+		streamed_tilemaps.push_back(this);
+		//chunks near the camera get their colliders before the first update
+		auto camera = common::renderer->get_active_camera();
+		if (camera != nullptr)
+			stream_chunks(camera->get_view_center_location(), camera->ortho_width);
+		return;
+	}
+
+	size_t chunk_index = 0;
+	int layer_index = 0;
+	for (auto& layer : tilemap_asset->layers)
+	{
+		for (auto& chunk : layer.chunks)
+		{
+			tilemap_asset->acquire_chunk(chunk);
+			acquired_chunks.at(chunk_index) = true;
+			build_chunk_colliders(chunk_index, chunk, layer_index);
+			chunk_index++;
+		}
+		layer_index++;
+	}
+}
+
+void tilemap::stream_chunks(glm::vec2 view_center, float ortho_width)
+{
+	float tile_x_size = static_cast<float>(tileset_asset->tile_width / common::pixels_per_world_unit);
+	float tile_y_size = static_cast<float>(tileset_asset->tile_width / common::pixels_per_world_unit);
+
+	//view center in tiles, relative to the top left tile of the map
+	glm::vec2 local = view_center - owner->get_location();
+	float column = local.x / tile_x_size + (float(tilemap_asset->width) / 2 - 0.5f);
+	float row = (float(tilemap_asset->height) / 2 - 0.5f) - local.y / tile_y_size;
+
+	int center_column = static_cast<int>(std::floor(column));
+	int center_row = static_cast<int>(std::floor(row));
+	if (center_column == streamed_column && center_row == streamed_row && ortho_width == streamed_ortho_width)
+		return;
+	streamed_column = center_column;
+	streamed_row = center_row;
+	streamed_ortho_width = ortho_width;
+
+	//viewport height never exceeds its width, margin prevents popping at the edges
+	constexpr float margin_tiles = 8;
+	float radius_x = ortho_width / 2 / tile_x_size + margin_tiles;
+	float radius_y = ortho_width / 2 / tile_y_size + margin_tiles;
+	float left = column - radius_x + tilemap_asset->origin_x;
+	float right = column + radius_x + tilemap_asset->origin_x;
+	float top = row - radius_y + tilemap_asset->origin_y;
+	float bottom = row + radius_y + tilemap_asset->origin_y;
+
+	bool changed = false;
+	size_t chunk_index = 0;
+	int layer_index = 0;
+	for (auto& layer : tilemap_asset->layers)
+	{
+		for (auto& chunk : layer.chunks)
+		{
+			bool needed = chunk.x <= right && chunk.x + static_cast<int>(chunk.width) >= left
+				&& chunk.y <= bottom && chunk.y + static_cast<int>(chunk.height) >= top;
+
+			if (needed != acquired_chunks.at(chunk_index))
+			{
+				if (needed)
+				{
+					tilemap_asset->acquire_chunk(chunk);
+					build_chunk_colliders(chunk_index, chunk, layer_index);
+				}
+				else
+				{
+					destroy_chunk_colliders(chunk_index);
+					tilemap_asset->release_chunk(chunk);
+				}
+				acquired_chunks.at(chunk_index) = needed;
+				changed = true;
+			}
+			chunk_index++;
+		}
+		layer_index++;
+	}
+
+	if (changed)
+		mark_pipeline_dirty();
+}
+
+void tilemap::update_streamed_tilemaps()
+{
+	auto camera = common::renderer->get_active_camera();
+	if (camera == nullptr)
+		return;
+
+	for (auto& tilemap : streamed_tilemaps)
+		tilemap->stream_chunks(camera->get_view_center_location(), camera->ortho_width);
 }
 
 #include "collider.h"
+#include "source/physics/dynamics_manager.h"
+
+#include "include/glm/glm.hpp"
 
-void tilemap::build_colliders()
+#include <cfloat>
+
+void tilemap::build_chunk_colliders(size_t chunk_index, const assets::tilemap::chunk& chunk, int layer_index)
 {
 	auto check_if_tile_collide = [&](const int& tile) -> bool
 	{
@@ -101,55 +213,97 @@ void tilemap::build_colliders()
 		return itr != tileset_asset->colliding_tiles.end();
 	};
 
-	int layer_counter = 0;
-
 	float tile_x_size = static_cast<float>(tileset_asset->tile_width / common::pixels_per_world_unit);
 	float tile_y_size = static_cast<float>(tileset_asset->tile_width / common::pixels_per_world_unit);
 	glm::vec2 extend = { tile_x_size * 2, tile_y_size * 2 };
 
-	for (auto& layer : tilemap_asset->layers)
+	float base_x = static_cast<float>(-1 * (float(tilemap_asset->width) / 2 - 0.5) * tile_x_size);
+	float base_y = static_cast<float>(-1 * (float(tilemap_asset->height) / 2 - 0.5) * tile_y_size);
+
+	auto& colliders = chunk_colliders.at(chunk_index);
+	const uint32_t* tile = chunk.tiles.data();
+	for (unsigned int y = 0; y < chunk.height; y++)
 	{
-		float y_mod = static_cast<float>(-1 * (float(tilemap_asset->height) / 2 - 0.5) * tile_y_size);
-		auto row = layer.end();
+		int row = chunk.y + static_cast<int>(y) - tilemap_asset->origin_y;
+		float y_mod = base_y + (static_cast<int>(tilemap_asset->height) - 1 - row) * tile_y_size;
+		float x_mod = base_x + (chunk.x - tilemap_asset->origin_x) * tile_x_size;
 
-		do
+		for (unsigned int x = 0; x < chunk.width; x++, tile++, x_mod += tile_x_size)
 		{
-			row--;
-
-			float x_mod = static_cast<float>(-1 * (float(tilemap_asset->width) / 2 - 0.5) * tile_x_size);
-			for (auto& tile : *row)
-			{
-				if (!check_if_tile_collide(tile))
-				{
-					x_mod += tile_x_size;
-					continue;
-				}
-
-				auto collider = new components::collider{ uint32_t(owned_colliders.size()), preset, extend };
-				collider->layer_offset = layer_counter;
-				collider->entity_offset = { x_mod, y_mod };
-				collider->initialize_in_tilemap(owner);
-				owned_colliders.push_back(collider);
-				collider->on_attach();
-				x_mod += tile_x_size;
-			}
-			y_mod += tile_y_size;
+			if (!check_if_tile_collide(static_cast<int>(*tile)))
+				continue;
+
+			auto collider = new components::collider{ colliders_id_iterator++, preset, extend };
+			collider->set_layer_offset(layer_index);
+			collider->set_entity_offset({ x_mod, y_mod });
+			collider->initialize_in_tilemap(owner);
+			colliders.push_back(collider);
+			collider->on_attach();
 		}
-		while (row != layer.begin());
+	}
+}
 
-		layer_counter++;
+void tilemap::destroy_chunk_colliders(size_t chunk_index)
+{
+	auto& colliders = chunk_colliders.at(chunk_index);
+	for (auto& collider : colliders)
+	{
+		collider->wake_on_destroy = false;
+		delete collider;
 	}
+	colliders.clear();
+}
+
+void tilemap::on_owner_changed()
+{
+	mesh::on_owner_changed();
+	for (auto& colliders : chunk_colliders)
+		for (auto& collider : colliders)
+			collider->refresh();
 }
 
 uint32_t tilemap::get_instances_amount()
 {
-	return static_cast<uint32_t>(tilemap_asset->width * tilemap_asset->height * tilemap_asset->layers.size());
+	uint32_t amount = 0;
+	size_t chunk_index = 0;
+	for (auto& layer : tilemap_asset->layers)
+		for (auto& chunk : layer.chunks)
+			if (acquired_chunks.at(chunk_index++))
+				amount += chunk.width * chunk.height;
+	return amount;
 }
 
 tilemap::~tilemap()
 {
-	for (auto& collider : owned_colliders)
-		delete collider;
+	//Bodies resting on the tiles are woken once over the bounds of all of them
+	glm::vec2 bounds_min = { FLT_MAX, FLT_MAX };
+	glm::vec2 bounds_max = { -FLT_MAX, -FLT_MAX };
+	bool had_colliders = false;
+	for (auto& colliders : chunk_colliders)
+		for (auto& collider : colliders)
+		{
+			glm::vec2 half = glm::abs(collider->extend) / 2.0f;
+			bounds_min = glm::min(bounds_min, collider->get_world_pos() - half);
+			bounds_max = glm::max(bounds_max, collider->get_world_pos() + half);
+			collider->wake_on_destroy = false;
+			delete collider;
+			had_colliders = true;
+		}
+	if (had_colliders)
+	{
+		glm::vec2 margin = { 0.1f, 0.1f };
+		common::dynamics_manager->wake_in_box(bounds_min - margin, bounds_max + margin);
+	}
+
+	size_t chunk_index = 0;
+	for (auto& layer : tilemap_asset->layers)
+		for (auto& chunk : layer.chunks)
+			if (chunk_index < acquired_chunks.size() && acquired_chunks.at(chunk_index++))
+				tilemap_asset->release_chunk(chunk);
+
+	auto itr = std::find(streamed_tilemaps.begin(), streamed_tilemaps.end(), this);
+	if (itr != streamed_tilemaps.end())
+		streamed_tilemaps.erase(itr);
 
 	common::renderer->unregister_mesh_component(this);
-}
\ No newline at end of file
+}
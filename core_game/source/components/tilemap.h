@@ -4,6 +4,8 @@
 #include "source/assets/tileset_asset.h"
 #include "source/physics/collision.h"
 
+#include <climits>
+
 namespace entities
 {
 	namespace components
@@ -13,18 +15,45 @@ namespace entities
 		/*
 			tilemap
 			renders tilemap with given tileset
+			chunks of infinite tilemaps are resident only near the active camera,
+			and only resident chunks have colliders
 		*/
 		class tilemap : virtual public entities::components::mesh
 		{
 		protected:
-			std::vector<collider*> owned_colliders;
+			virtual void expose_types(component_slots& slots) override { expose_type(slots, this); mesh::expose_types(slots); };
+			virtual void on_owner_changed() override;
+		public:
+			static constexpr component_type type_id = component_type::tilemap;
+		protected:
+			//colliders of the colliding tiles, indexed like acquired_chunks
+			std::vector<std::vector<collider*>> chunk_colliders;
+			uint32_t colliders_id_iterator = 0;
 			std::shared_ptr<assets::tilemap> tilemap_asset;
 			std::shared_ptr<assets::tileset> tileset_asset;
 			rendering::render_config _config;
 			physics::collision_preset preset = 0;
 			unsigned int layers_stride = 1;
+			//chunks acquired by this component, indexed layer by layer
+			std::vector<bool> acquired_chunks;
+			int streamed_column = INT_MIN;
+			int streamed_row = INT_MIN;
+			float streamed_ortho_width = 0;
 			virtual void pass_transformation(rendering::transformations_buffer_stream& tbi) override;
-			void build_colliders();
+			/*
+				build_chunk_colliders
+				creates colliders of the colliding tiles of the acquired chunk
+				-l-
+				[layer_index] index of the chunk layer in the tilemap
+			*/
+			void build_chunk_colliders(size_t chunk_index, const assets::tilemap::chunk& chunk, int layer_index);
+			/*
+				destroy_chunk_colliders
+				destroys colliders of the chunk without waking bodies around them,
+				so bodies sleeping on a chunk far from the camera stay where they are
+			*/
+			void destroy_chunk_colliders(size_t chunk_index);
+			void stream_chunks(glm::vec2 view_center, float ortho_width);
 		public:
 			unsigned int get_layers_stride() { return layers_stride; };
 			void set_layers_stride(unsigned int new_stride) { layers_stride = new_stride; mark_pipeline_dirty(); };
@@ -38,6 +67,11 @@ namespace entities
 				physics::collision_preset _preset
 			);
 			~tilemap();
+			/*
+				update_streamed_tilemaps
+				makes chunks of infinite tilemaps near the active camera resident, and releases the far ones
+			*/
+			static void update_streamed_tilemaps();
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "command_buffer.h"
+#include "entity.h"
+#include "world.h"
+
+#include "source/common/common.h"
+
+using namespace entities;
+
+void command_buffer::kill(entity_handle entity)
+{
+	auto e = common::entity_registry->get(entity);
+	if (e == nullptr || e->kill_queued)
+		return;
+	e->kill_queued = true;
+	commands.push_back({ command::type::kill, entity, 0 });
+}
+
+void command_buffer::kill_component(entity_handle entity, uint32_t id)
+{
+	commands.push_back({ command::type::kill_component, entity, id });
+}
+
+void command_buffer::set_layer(entity_handle entity, uint8_t layer)
+{
+	commands.push_back({ command::type::set_layer, entity, layer });
+}
+
+void command_buffer::remove_scene(uint32_t name)
+{
+	commands.push_back({ command::type::remove_scene, {}, name });
+}
+
+void command_buffer::flush()
+{
+	while (!commands.empty())
+	{
+		flushed.swap(commands);
+		for (auto& c : flushed)
+		{
+			if (c.type == command::type::remove_scene)
+			{
+				common::world->remove_scene(c.value);
+				continue;
+			}
+
+			auto e = common::entity_registry->get(c.entity);
+			if (e == nullptr)
+				continue;
+
+			switch (c.type)
+			{
+			case command::type::kill:
+				e->kill();
+				break;
+			case command::type::kill_component:
+				e->kill_component(c.value);
+				break;
+			case command::type::set_layer:
+				e->set_layer(static_cast<uint8_t>(c.value));
+				break;
+			default:
+				break;
+			}
+		}
+		flushed.clear();
+	}
+}
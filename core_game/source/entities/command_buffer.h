@@ -0,0 +1,44 @@
+#pragma once
+#include "entity_registry.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace entities
+{
+	/*
+		command_buffer
+		structural changes requested by the game logic, applied together at the sync points of the frame
+		so entities and components are never destroyed while the managers iterate over them
+		commands queued while the buffer is flushed (e.g. by destroy functions) are applied in the same flush
+	*/
+	class command_buffer
+	{
+		struct command
+		{
+			enum class type : uint8_t
+			{
+				kill, kill_component, set_layer, remove_scene
+			} type;
+			entity_handle entity;
+			//component id, layer or scene name
+			uint32_t value;
+		};
+		std::vector<command> commands;
+		std::vector<command> flushed;
+	public:
+		/*
+			kill
+			entity stops being reported as alive to the game logic immediately
+		*/
+		void kill(entity_handle entity);
+		void kill_component(entity_handle entity, uint32_t id);
+		void set_layer(entity_handle entity, uint8_t layer);
+		void remove_scene(uint32_t name);
+		/*
+			flush
+			applies the queued commands, commands of dead entities are skipped
+		*/
+		void flush();
+	};
+}
@@ -3,9 +3,9 @@
 
 using namespace entities;
 
-std::weak_ptr<entity> component::get_owner_weak()
+entity_handle component::get_owner_handle()
 {
-	return owner->self;
+	return owner->get_handle();
 }
 
 glm::vec2& component::get_owner_location()
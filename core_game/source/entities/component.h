@@ -2,10 +2,40 @@
 #include <cstdint>
 #include <memory>
 #include "include/glm/vec2.hpp"
+#include "source/utilities/inline_vector.h"
+#include "entity_registry.h"
 
 namespace entities
 {
 	class entity;
+	class component;
+
+	/*
+		component_type
+		compile-time id of the component class, every component class declares it as its type_id
+	*/
+	enum class component_type : uint8_t
+	{
+		behavior, camera, collider, dynamics, flipbook, listener, mesh, sound_emitter, sprite, static_mesh, tilemap
+	};
+
+	/*
+		component_slot
+		typed entry of the component in the entity
+		component deriving from other component classes has a slot for each of them
+		-l-
+		[pointer]	points to the subobject of the slot type
+		[base]		component the slot belongs to
+	*/
+	struct component_slot
+	{
+		component_type type;
+		uint32_t id;
+		void* pointer;
+		component* base;
+	};
+
+	using component_slots = utilities::inline_vector<component_slot, 8>;
 
 	class component
 	{
@@ -14,10 +44,27 @@ namespace entities
 		uint32_t id;
 		entity* owner = nullptr;
 		glm::vec2& get_owner_location();
+		/*
+			expose_types
+			adds slots of the component class and of every component class it derives from
+			called when component is attached
+		*/
+		virtual void expose_types(component_slots& slots) {};
+		/*
+			on_owner_changed
+			called when location or layer of the owner changes
+		*/
+		virtual void on_owner_changed() {};
+		template<class T>
+		void expose_type(component_slots& slots, T* typed)
+		{
+			slots.push_back({ T::type_id, id, typed, this });
+		};
 	public:
 		component(uint32_t _id) : id(_id) {};
-		std::weak_ptr<entity> get_owner_weak();
+		entity_handle get_owner_handle();
+		entity* get_owner() { return owner; }
 		virtual ~component() {};
 		virtual void on_attach() = 0;
 	};
-}
\ No newline at end of file
+}
@@ -12,19 +12,21 @@
 
 #include "source/behaviors/behaviors_manager.h"
 #include "source/behaviors/frame.h"
+#include "source/events/event_bus.h"
 
 #include <vector>
+#include <algorithm>
 
-entities::entity::entity()
+entities::entity::entity() 
+	: handle(common::entity_registry->create(this)), parent_scene(common::world->get_persistent_scene()), scene_index(parent_scene->entities.size())
 {
-	self = std::shared_ptr<entity>{ this };
-	common::world->get_persistent_scene()->entities.push_back(self);
+	parent_scene->entities.push_back(handle);
 }
 
-entities::entity::entity(scene* parent_scene)
+entities::entity::entity(scene* _parent_scene) 
+	: handle(common::entity_registry->create(this)), parent_scene(_parent_scene), scene_index(_parent_scene->entities.size())
 {
-	self = std::shared_ptr<entity>{ this };
-	parent_scene->entities.push_back(self);
+	parent_scene->entities.push_back(handle);
 
 	auto f = common::behaviors_manager->get_current_frame();
 	if (f->scene_context != common::world->get_persistent_scene())
@@ -35,46 +37,10 @@ void entities::entity::attach_component(component* comp)
 {
 	components.push_back(comp);
 	comp->owner = this;
+	comp->expose_types(slots);
 	comp->on_attach();
 }
 
-void call_on_collide(std::weak_ptr<entities::entity> entity, std::weak_ptr<entities::entity> other)
-{
-	for (auto& comp : entity.lock()->get_components())
-	{
-		auto behavior = dynamic_cast<entities::components::behavior*>(comp);
-		if (behavior != nullptr)
-			behavior->call_function(behaviors::functions::on_collide, other);
-	}
-
-	for (auto& comp : other.lock()->get_components())
-	{
-		auto behavior = dynamic_cast<entities::components::behavior*>(comp);
-		if (behavior != nullptr)
-			behavior->call_function(behaviors::functions::on_collide, entity);
-	}
-}
-
-void call_on_overlap(std::vector<std::weak_ptr<entities::entity>>& overlaping_entities)
-{
-	if (overlaping_entities.size() == 1) return;
-
-	for (auto& entity : overlaping_entities)
-		for (auto& other : overlaping_entities)
-		{
-			if (other.expired()) continue;
-			if (&entity == &other) continue;
-			for (auto& comp : entity.lock()->get_components())
-			{
-				auto bhv = dynamic_cast<entities::components::behavior*>(comp);
-				if (bhv == nullptr) continue;
-				bhv->call_function(behaviors::functions::on_overlap, other);
-				if (entity.expired()) break;
-			}
-			if (entity.expired()) break;
-		}
-}
-
 const glm::vec2& entities::entity::get_location()
 {
 	return location;
@@ -87,15 +53,21 @@ void entities::entity::teleport(glm::vec2 new_location)
 		new_location += f->scene_context->world_offset;
 
 	location = new_location;
+	notify_components();
+}
+
+void entities::entity::set_layer(uint8_t new_layer)
+{
+	if (layer == new_layer)
+		return;
+	layer = new_layer;
+	notify_components();
+}
+
+void entities::entity::notify_components()
+{
 	for (auto& c : components)
-	{
-		auto m_ptr = dynamic_cast<components::mesh*>(c);
-		if (m_ptr != nullptr)
-		{
-			m_ptr->mark_pipeline_dirty();
-			continue;
-		}
-	};
+		c->on_owner_changed();
 }
 
 physics::collision_event entities::entity::sweep(glm::vec2 new_location)
@@ -105,58 +77,36 @@ physics::collision_event entities::entity::sweep(glm::vec2 new_location)
 	std::vector<physics::sweep_move_event*> events;
 	int closest_event_id = -1;
 
-	std::vector<components::dynamics*> dynamics_components;
-
-	for (auto& c : components)
+	for_each_component<components::collider>([&](components::collider* c_ptr)
 	{
-		auto c_ptr = dynamic_cast<components::collider*>(c);
-		if (c_ptr != nullptr)
-		{
-			auto current_event = common::collision_solver->sweep_move(c_ptr, new_location);
-			
-			if (current_event == nullptr) continue;
-
-			events.push_back(current_event);
-			
-			if (
-				events.back()->collide_event != nullptr &&														//If there was a collide
-				(closest_event_id == -1 ||																		//And there was no hit before
-				events.back()->collide_event->distance < events.at(closest_event_id)->collide_event->distance)	//Or this hit is closer than previous
-			)	
-				closest_event_id = static_cast<int>(events.size() - 1);
-		}
-		auto m_ptr = dynamic_cast<components::mesh*>(c);
-		if (m_ptr != nullptr)
-		{
-			m_ptr->mark_pipeline_dirty();
-			continue;
-		}
-		auto d_ptr = dynamic_cast<components::dynamics*>(c);
-		if (d_ptr != nullptr)
-		{
-			dynamics_components.push_back(d_ptr);
-			continue;
-		}
-	}
+		auto current_event = common::collision_solver->sweep_move(c_ptr, new_location);
 
-	std::vector<std::weak_ptr<entities::entity>> overlaping_entities;
+		if (current_event == nullptr) return;
 
-	if (closest_event_id == -1)
-		for (auto& sweep : events)
-			for (auto& ovr : sweep->overlap_events)
-				overlaping_entities.push_back(ovr->other->get_owner_weak());
-	else
-	{
-		physics::collision_event* collide_event = events.at(closest_event_id)->collide_event;
-		for (auto& sweep : events)
-			for (auto& ovr : sweep->overlap_events)
-				if (ovr->distance < collide_event->distance)		//Check if overlap is closer than collide event
-					overlaping_entities.push_back(ovr->other->get_owner_weak());
-	}
+		events.push_back(current_event);
 
-	overlaping_entities.push_back(get_weak());
-	if (overlaping_entities.size() != 0)
-		call_on_overlap(overlaping_entities);
+		if (
+			events.back()->collide_event != nullptr &&														//If there was a collide
+			(closest_event_id == -1 ||																		//And there was no hit before
+			events.back()->collide_event->distance < events.at(closest_event_id)->collide_event->distance)	//Or this hit is closer than previous
+		)
+			closest_event_id = static_cast<int>(events.size() - 1);
+	});
+
+	//Overlaps are queued as pairs with the moving entity, each overlapped entity once
+	std::vector<entity*> overlaping_entities;
+	physics::collision_event* collide_event = closest_event_id == -1 ? nullptr : events.at(closest_event_id)->collide_event;
+	for (auto& sweep : events)
+		for (auto& ovr : sweep->overlap_events)
+		{
+			if (collide_event != nullptr && ovr->distance >= collide_event->distance)	//Check if overlap is closer than collide event
+				continue;
+			entity* other = ovr->other->owner;
+			if (other == this || std::find(overlaping_entities.begin(), overlaping_entities.end(), other) != overlaping_entities.end())
+				continue;
+			overlaping_entities.push_back(other);
+			common::event_bus->emit_overlap(handle, other->handle);
+		}
 
 	physics::collision_event result_collide;
 
@@ -170,12 +120,14 @@ physics::collision_event entities::entity::sweep(glm::vec2 new_location)
 		location += events.at(closest_event_id)->velocity;
 		result_collide = *events.at(closest_event_id)->collide_event;
 
-		for (auto& d : dynamics_components)
-			d->collide_event(result_collide.normal);
+		for_each_component<components::dynamics>([&](components::dynamics* d) { d->collide_event(result_collide.normal); });
+		result_collide.other->get_owner()->for_each_component<components::dynamics>([](components::dynamics* d) { d->wake_up(); });
 
-		call_on_collide(get_weak(), result_collide.other->get_owner_weak());
+		common::event_bus->emit_collide(handle, result_collide.other->get_owner_handle());
 	}
 
+	notify_components();
+
 	for (auto& e : events)
 		delete e;
 
@@ -190,28 +142,55 @@ entities::component* entities::entity::get_component(uint32_t id)
 	return nullptr;
 }
 
+/*
+	detach_component
+	removes component and its slots, so it can't be found while it is destroyed
+*/
+static void detach_component(utilities::inline_vector<entities::component*, 4>& components, entities::component_slots& slots, size_t index)
+{
+	entities::component* comp = components[index];
+	slots.erase_if([comp](const entities::component_slot& slot) { return slot.base == comp; });
+	components.erase(index);
+}
+
 void entities::entity::kill_component(uint32_t id)
-{;
-	for (auto itr = components.begin(); itr != components.end(); itr++)
-		if ((*itr)->id == id)
+{
+	for (size_t i = 0; i < components.size(); i++)
+		if (components[i]->id == id)
 		{
-			delete (*itr);
-			components.erase(itr);
+			component* comp = components[i];
+			detach_component(components, slots, i);
+			delete comp;
+			return;
 		}
 }
 
 void entities::entity::kill()
 {
-	for (auto& comp : components)
+	if (killed)
+		return;
+	killed = true;
+
+	//components are detached one by one, so the ones destroyed later are still accessible
+	while (!components.empty())
+	{
+		component* comp = components[0];
+		detach_component(components, slots, 0);
 		delete comp;
-	self.reset();
-}
+	}
 
-std::weak_ptr<entities::entity> entities::entity::get_weak()
-{
-	return self;
+	//swap and pop from the scene entities
+	auto& members = parent_scene->entities;
+	members[scene_index] = members.back();
+	common::entity_registry->get(members[scene_index])->scene_index = scene_index;
+	members.pop_back();
+
+	common::entity_registry->release(handle);
+	delete this;
 }
 
 entities::entity::~entity()
 {
+	if (lua_reference != LUA_NOREF && common::behaviors_manager != nullptr)
+		common::behaviors_manager->release_entity_reference(lua_reference);
 }
\ No newline at end of file
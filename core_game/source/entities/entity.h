@@ -1,34 +1,68 @@
 #pragma once
 #include "component.h"
+#include "entity_registry.h"
 #include "source/physics/collision.h"
 
 #include "include/glm/vec2.hpp"
-
-#include <memory>
-#include <list>
+#include "include/lua_5_4_2/include/lauxlib.h"
 
 namespace entities
 {
 	class component;
+	class scene;
 
+	/*
+		entity
+		entities are owned by the world, they are created with new and destroy themselves in entity::kill
+		other objects refer to them by entity_handle
+	*/
 	class entity
 	{
-	friend std::shared_ptr<entities::entity>;
 	friend class scene;
+	friend class command_buffer;
 	friend component;
 	protected:
-		std::list<component*> components;
-		std::shared_ptr<entity> self;
+		utilities::inline_vector<component*, 4> components;
+		component_slots slots;
+		/*
+			notify_components
+			informs components that location or layer changed
+		*/
+		void notify_components();
+		entity_handle handle;
+		scene* parent_scene;
+		//index in parent_scene::entities
+		size_t scene_index;
+		//set at the beginning of entity::kill, so kill called by destroy functions does nothing
+		bool killed = false;
+		//set when kill is queued in the command buffer
+		bool kill_queued = false;
 		glm::vec2 location{ 0.0f, 0.0f };
+		~entity();
 	public:
+		/*
+			layer
+			read only, changed with set_layer so components can follow it
+		*/
 		uint8_t layer = 0;
+		/*
+			lua_reference
+			lua registry reference of the entity userdata, created when entity is passed to lua for the first time
+			LUA_NOREF if there is none
+		*/
+		int lua_reference = LUA_NOREF;
 		entity();
 		entity(scene* parent_scene);
 		/*
 			kill
-			destroys the entity and all of its components
+			destroys the entity and all of its components, entity is deleted and must not be used after the call
 		*/
 		void kill();
+		/*
+			is_kill_queued
+			returns true if entity will be killed at the next flush of the command buffer
+		*/
+		bool is_kill_queued() { return kill_queued; }
 
 		/*
 			get_location
@@ -48,6 +82,12 @@ namespace entities
 		*/
 		physics::collision_event sweep(glm::vec2 new_location);
 
+		/*
+			set_layer
+			changes entity layer
+		*/
+		void set_layer(uint8_t new_layer);
+
 		/*
 			attach_component
 			adds component to the entity
@@ -60,6 +100,33 @@ namespace entities
 		*/
 		component* get_component(uint32_t id);
 
+		/*
+			get_component
+			returns component of given id and type, nullptr if there is no such component
+			lookup goes through the component slots, without rtti
+		*/
+		template<class T>
+		T* get_component(uint32_t id)
+		{
+			for (auto& slot : slots)
+				if (slot.type == T::type_id && slot.id == id)
+					return static_cast<T*>(slot.pointer);
+			return nullptr;
+		}
+
+		/*
+			for_each_component
+			calls func with every component of given type
+			components must not be attached nor killed by func
+		*/
+		template<class T, class function>
+		void for_each_component(function func)
+		{
+			for (auto& slot : slots)
+				if (slot.type == T::type_id)
+					func(static_cast<T*>(slot.pointer));
+		}
+
 		/*
 			kill_component
 			destroys component of given id
@@ -67,13 +134,11 @@ namespace entities
 		void kill_component(uint32_t id);
 
 		/*
-			get_weak
-			returns weak pointer connected with entity::self
+			get_handle
+			returns handle of the entity in the entity registry
 		*/
-		std::weak_ptr<entities::entity> get_weak();
+		entity_handle get_handle() { return handle; }
 
-		inline const std::list<component*> get_components() { return components; };
-
-		~entity();
+		inline const utilities::inline_vector<component*, 4>& get_components() { return components; };
 	};
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "entity_registry.h"
+
+using namespace entities;
+
+entity_handle entity_registry::create(entity* e)
+{
+	alive++;
+	if (free_slots.empty())
+	{
+		slots.push_back({ e, 0 });
+		return { static_cast<uint32_t>(slots.size() - 1), 0 };
+	}
+
+	uint32_t index = free_slots.back();
+	free_slots.pop_back();
+	slots[index].e = e;
+	return { index, slots[index].generation };
+}
+
+void entity_registry::release(entity_handle handle)
+{
+	auto& s = slots[handle.index];
+	s.e = nullptr;
+	s.generation++;
+	free_slots.push_back(handle.index);
+	alive--;
+}
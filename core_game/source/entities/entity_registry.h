@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace entities
+{
+	class entity;
+
+	/*
+		entity_handle
+		generational reference to the entity in the entity registry
+		handle of a killed entity never resolves again, even when its slot is reused
+	*/
+	struct entity_handle
+	{
+		static constexpr uint32_t invalid_index = UINT32_MAX;
+		uint32_t index = invalid_index;
+		uint32_t generation = 0;
+
+		bool operator==(const entity_handle& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const entity_handle& other) const { return !(*this == other); }
+	};
+
+	/*
+		entity_registry
+		dense table of the alive entities, indexed by the entity handles
+		slots of killed entities are reused, their generation is incremented when they are released
+	*/
+	class entity_registry
+	{
+		struct slot
+		{
+			entity* e = nullptr;
+			uint32_t generation = 0;
+		};
+		std::vector<slot> slots;
+		std::vector<uint32_t> free_slots;
+		size_t alive = 0;
+	public:
+		/*
+			create
+			returns handle of the new entity
+		*/
+		entity_handle create(entity* e);
+		/*
+			release
+			invalidates the handle, called when entity is killed
+		*/
+		void release(entity_handle handle);
+		/*
+			get
+			returns entity of the handle, nullptr if the entity is dead
+		*/
+		entity* get(entity_handle handle) const
+		{
+			if (handle.index >= slots.size())
+				return nullptr;
+			auto& s = slots[handle.index];
+			return s.generation == handle.generation ? s.e : nullptr;
+		}
+		/*
+			size
+			returns amount of alive entities
+		*/
+		size_t size() const { return alive; }
+	};
+}
@@ -1,11 +1,10 @@
 #include "scene.h"
 #include "source/common/common.h"
 #include "source/behaviors/behaviors_manager.h"
+#include "source/events/event_bus.h"
 
 using namespace entities;
 
-constexpr int purge_triggering_dangling_pointers_amount = 30 * 60;  //Purge every 30 seconds
-
 scene::scene(uint32_t _name, glm::vec2 _world_offset) : name(_name), world_offset(_world_offset)
 {
 }
@@ -35,28 +34,16 @@ scene::~scene()
         common::behaviors_manager->pop_frame();
     }
 
-    for (auto& e : entities)
-        if (!e.expired())
-            e.lock()->kill();
+    //destroy functions can kill or create entities of the scene
+    while (!entities.empty())
+        common::entity_registry->get(entities.back())->kill();
+
+    common::behaviors_manager->cancel_scene_tasks(this);
+    common::event_bus->unsubscribe_scene(this);
 }
 
 void scene::update()
 {
-    frames_since_purged++;
-	if (frames_since_purged > purge_triggering_dangling_pointers_amount)
-	{
-        frames_since_purged = 0;
-        auto iter = entities.begin();
-        while (iter != entities.end()) {
-            if (iter->expired()) {
-                iter = entities.erase(iter);
-            }
-            else {
-                ++iter;
-            }
-        }
-	}
-
     if (_scene.get() == nullptr ||
         !common::behaviors_manager->prepare_scene_function_call(behaviors::functions::update, _scene.get()))
         return;
@@ -20,22 +20,14 @@ namespace entities
 	public:
 		/*
 			entities
-			vector of entities owned by the scene
+			handles of entities owned by the scene, all of them are alive
+			entities remove themselves with swap and pop when they are killed
 			when scene is deleted it will call entity::kill on every owned entity
-			may contain expired pointers
 		*/
-		std::vector<std::weak_ptr<entity>> entities;
+		std::vector<entity_handle> entities;
 		const uint32_t name;
 		const glm::vec2 world_offset;
 	protected:
-		/*
-			frames_since_purged
-			as entities can be destroyed due to game logic
-			scene::entities can contains expired pointers which can slow down the game
-			frames_since_purged counts frames since the last scene::entities purging from expired pointers
-			and triggers purge when it reaches value definied in .cpp file
-		*/
-		int frames_since_purged = 0;
 		std::shared_ptr<assets::scene> _scene;
 	public:
 		scene(uint32_t _name, glm::vec2 world_offset);
@@ -1,11 +1,15 @@
 #include "world.h"
 #include "source/common/crash.h"
+#include "source/common/common.h"
+#include "source/events/event_bus.h"
 #include <list>
 
 namespace entities
 {
 	struct world::implementation
 	{
+		//destroyed last, destroy functions of the scenes can still queue commands
+		command_buffer commands;
 		std::unique_ptr<scene> persistent_scene;
 		std::list<std::unique_ptr<scene>> scenes;
 	};
@@ -36,6 +40,7 @@ namespace entities
 
 		auto s = std::make_unique<scene>(name, world_offset, _scene);
 		impl->scenes.push_back(std::move(s));
+		common::event_bus->emit_scene_loaded(name);
 	}
 
 	void world::remove_scene(uint32_t name)
@@ -60,4 +65,14 @@ namespace entities
 	{
 		return impl->persistent_scene.get();
 	}
+
+	command_buffer& world::get_commands()
+	{
+		return impl->commands;
+	}
+
+	void world::flush_commands()
+	{
+		impl->commands.flush();
+	}
 }
\ No newline at end of file
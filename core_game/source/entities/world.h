@@ -1,5 +1,6 @@
 #pragma once
 #include "source/entities/scene.h"
+#include "source/entities/command_buffer.h"
 
 namespace entities
 {
@@ -16,5 +17,15 @@ namespace entities
 		void remove_scene(uint32_t name);
 		scene* get_scene(uint32_t name);
 		scene* get_persistent_scene();
+		/*
+			get_commands
+			returns buffer of structural changes requested by the game logic
+		*/
+		command_buffer& get_commands();
+		/*
+			flush_commands
+			applies the queued structural changes, called at the sync points of the frame
+		*/
+		void flush_commands();
 	};
 }
\ No newline at end of file
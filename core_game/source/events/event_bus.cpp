@@ -0,0 +1,356 @@
+#include "event_bus.h"
+
+#include "source/common/common.h"
+#include "source/entities/entity.h"
+#include "source/components/behavior.h"
+#include "source/behaviors/behaviors_manager.h"
+#include "source/behaviors/frame.h"
+#include "source/utilities/hash_string.h"
+
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+constexpr int no_payload = -2;
+
+struct events::event_bus::implementation
+{
+	struct event
+	{
+		event_type type;
+		uint32_t channel;
+		entities::entity_handle source;
+		entities::entity_handle other;
+		//action name of input_action
+		std::string name;
+		//pressed state of input_action, scene name of scene_loaded
+		int64_t value = 0;
+		int payload_ref = no_payload;
+	};
+
+	struct subscription
+	{
+		uint64_t id;
+		int callback_ref;
+		//subscriptions made outside of behaviors (in scenes) have no database
+		bool has_database;
+		std::weak_ptr<behaviors::database> database;
+		entities::scene* scene;
+		bool has_source;
+		entities::entity_handle source;
+		bool removed = false;
+	};
+
+	std::unordered_map<entities::entity*, std::vector<entities::components::behavior*>> listeners;
+	std::unordered_map<uint32_t, std::vector<subscription>> subscriptions;
+	uint64_t subscriptions_id_iterator = 0;
+	bool has_removed_subscriptions = false;
+
+	std::vector<event> queue;
+	std::vector<event> dispatched;
+
+	bool is_alive(entities::entity_handle entity) { return common::entity_registry->get(entity) != nullptr; }
+	bool is_listened(entities::entity_handle entity, uint32_t channel);
+	void queue_pair(event_type type, entities::entity_handle entity, entities::entity_handle other);
+	void deliver_to_listeners(event& e);
+	void deliver_to_subscribers(event& e);
+	void remove_subscription(subscription& s);
+	void purge_subscriptions();
+};
+
+uint32_t events::get_channel(event_type type)
+{
+	switch (type)
+	{
+	case event_type::collide: return utilities::hash_string("collide");
+	case event_type::overlap: return utilities::hash_string("overlap");
+	case event_type::input_action: return utilities::hash_string("input_action");
+	case event_type::scene_loaded: return utilities::hash_string("scene_loaded");
+	default: return 0;
+	}
+}
+
+bool events::event_bus::implementation::is_listened(entities::entity_handle entity, uint32_t channel)
+{
+	auto e = common::entity_registry->get(entity);
+	if (e == nullptr)
+		return false;
+	return listeners.find(e) != listeners.end() || subscriptions.find(channel) != subscriptions.end();
+}
+
+void events::event_bus::implementation::queue_pair(
+	event_type type, entities::entity_handle entity, entities::entity_handle other)
+{
+	uint32_t channel = get_channel(type);
+	if (is_listened(entity, channel))
+		queue.push_back({ type, channel, entity, other });
+	if (is_listened(other, channel))
+		queue.push_back({ type, channel, other, entity });
+}
+
+void events::event_bus::implementation::deliver_to_listeners(event& e)
+{
+	auto source = common::entity_registry->get(e.source);
+	auto itr = listeners.find(source);
+	if (itr == listeners.end())
+		return;
+
+	auto function = e.type == event_type::collide ? behaviors::functions::on_collide : behaviors::functions::on_overlap;
+	//listeners can be removed by the called functions
+	auto called = itr->second;
+	for (auto& listener : called)
+	{
+		if (!is_alive(e.source) || !is_alive(e.other))
+			return;
+		auto current = listeners.find(source);
+		if (current == listeners.end())
+			return;
+		if (std::find(current->second.begin(), current->second.end(), listener) == current->second.end())
+			continue;
+		listener->call_function(function, e.other);
+	}
+}
+
+void events::event_bus::implementation::deliver_to_subscribers(event& e)
+{
+	auto itr = subscriptions.find(e.channel);
+	if (itr == subscriptions.end())
+		return;
+
+	if ((e.type == event_type::collide || e.type == event_type::overlap) && (!is_alive(e.source) || !is_alive(e.other)))
+		return;
+
+	//callbacks can subscribe to new channels and rehash the map, reference to the vector stays valid
+	//channels are erased only by purge_subscriptions, after the dispatch
+	auto& channel = itr->second;
+
+	//subscriptions added by the callbacks get the next events
+	size_t count = channel.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		//vector can grow during the call, so the subscription is copied
+		subscription s = channel[i];
+		if (s.removed)
+			continue;
+
+		if (s.has_source)
+		{
+			if (!is_alive(s.source))
+			{
+				remove_subscription(channel[i]);
+				continue;
+			}
+			if (s.source != e.source)
+				continue;
+		}
+
+		std::shared_ptr<behaviors::database> database;
+		if (s.has_database)
+		{
+			database = s.database.lock();
+			if (database == nullptr)
+			{
+				remove_subscription(channel[i]);
+				continue;
+			}
+		}
+
+		auto& manager = common::behaviors_manager;
+		manager->create_frame(database, s.scene);
+		manager->prepare_reference_call(s.callback_ref);
+		switch (e.type)
+		{
+		case event_type::collide:
+		case event_type::overlap:
+			manager->pass_entity_arg(e.source);
+			manager->pass_entity_arg(e.other);
+			manager->call(2, 0);
+			break;
+		case event_type::input_action:
+			manager->pass_string_arg(e.name);
+			manager->pass_bool_arg(e.value != 0);
+			manager->call(2, 0);
+			break;
+		case event_type::scene_loaded:
+			manager->pass_integer_arg(e.value);
+			manager->call(1, 0);
+			break;
+		case event_type::custom:
+			manager->pass_custom_function_args(e.payload_ref);
+			if (!is_alive(e.source))
+				manager->pass_nil();
+			else
+				manager->pass_entity_arg(e.source);
+			manager->call(2, 0);
+			break;
+		}
+		manager->pop_frame();
+	}
+}
+
+void events::event_bus::implementation::remove_subscription(subscription& s)
+{
+	if (s.removed)
+		return;
+	s.removed = true;
+	has_removed_subscriptions = true;
+	common::behaviors_manager->release_reference(s.callback_ref);
+}
+
+void events::event_bus::implementation::purge_subscriptions()
+{
+	if (!has_removed_subscriptions)
+		return;
+	has_removed_subscriptions = false;
+
+	for (auto itr = subscriptions.begin(); itr != subscriptions.end();)
+	{
+		auto& channel = itr->second;
+		channel.erase(std::remove_if(channel.begin(), channel.end(), [](const subscription& s) { return s.removed; }), channel.end());
+		if (channel.empty())
+			itr = subscriptions.erase(itr);
+		else
+			itr++;
+	}
+}
+
+events::event_bus::event_bus()
+{
+	impl = new implementation;
+}
+
+events::event_bus::~event_bus()
+{
+	delete impl;
+}
+
+void events::event_bus::clear()
+{
+	impl->listeners.clear();
+	impl->subscriptions.clear();
+	impl->has_removed_subscriptions = false;
+	impl->queue.clear();
+	impl->dispatched.clear();
+}
+
+void events::event_bus::register_listener(entities::entity* entity, entities::components::behavior* listener)
+{
+	impl->listeners[entity].push_back(listener);
+}
+
+void events::event_bus::unregister_listener(entities::entity* entity, entities::components::behavior* listener)
+{
+	auto itr = impl->listeners.find(entity);
+	if (itr == impl->listeners.end())
+		return;
+	auto& entity_listeners = itr->second;
+	entity_listeners.erase(std::remove(entity_listeners.begin(), entity_listeners.end(), listener), entity_listeners.end());
+	if (entity_listeners.empty())
+		impl->listeners.erase(itr);
+}
+
+void events::event_bus::emit_collide(entities::entity_handle entity, entities::entity_handle other)
+{
+	impl->queue_pair(event_type::collide, entity, other);
+}
+
+void events::event_bus::emit_overlap(entities::entity_handle entity, entities::entity_handle other)
+{
+	impl->queue_pair(event_type::overlap, entity, other);
+}
+
+void events::event_bus::emit_input_action(const std::string& action, bool pressed)
+{
+	uint32_t channel = get_channel(event_type::input_action);
+	if (!has_subscribers(channel))
+		return;
+	implementation::event e{ event_type::input_action, channel };
+	e.name = action;
+	e.value = pressed;
+	impl->queue.push_back(std::move(e));
+}
+
+void events::event_bus::emit_scene_loaded(uint32_t scene_name)
+{
+	uint32_t channel = get_channel(event_type::scene_loaded);
+	if (!has_subscribers(channel))
+		return;
+	implementation::event e{ event_type::scene_loaded, channel };
+	e.value = scene_name;
+	impl->queue.push_back(std::move(e));
+}
+
+void events::event_bus::emit_custom(uint32_t channel, int payload_ref, entities::entity_handle source)
+{
+	if (!has_subscribers(channel))
+	{
+		common::behaviors_manager->release_reference(payload_ref);
+		return;
+	}
+	implementation::event e{ event_type::custom, channel, source };
+	e.payload_ref = payload_ref;
+	impl->queue.push_back(std::move(e));
+}
+
+uint64_t events::event_bus::subscribe(uint32_t channel, int callback_ref, entities::entity_handle source, bool has_source)
+{
+	auto frame = common::behaviors_manager->get_current_frame();
+
+	implementation::subscription s;
+	s.id = ++impl->subscriptions_id_iterator;
+	s.callback_ref = callback_ref;
+	s.has_database = frame->target_object_database != nullptr;
+	s.database = frame->target_object_database;
+	s.scene = frame->scene_context;
+	s.has_source = has_source;
+	s.source = source;
+	impl->subscriptions[channel].push_back(s);
+	return s.id;
+}
+
+void events::event_bus::unsubscribe(uint64_t id)
+{
+	for (auto& channel : impl->subscriptions)
+		for (auto& s : channel.second)
+			if (s.id == id)
+			{
+				impl->remove_subscription(s);
+				return;
+			}
+}
+
+void events::event_bus::unsubscribe_scene(entities::scene* scene)
+{
+	for (auto& channel : impl->subscriptions)
+		for (auto& s : channel.second)
+			if (s.scene == scene)
+				impl->remove_subscription(s);
+}
+
+bool events::event_bus::has_subscribers(uint32_t channel)
+{
+	return impl->subscriptions.find(channel) != impl->subscriptions.end();
+}
+
+void events::event_bus::dispatch()
+{
+	for (int round = 0; round < max_dispatch_rounds && !impl->queue.empty(); round++)
+	{
+		impl->dispatched.swap(impl->queue);
+		for (auto& e : impl->dispatched)
+		{
+			if (e.type == event_type::collide || e.type == event_type::overlap)
+			{
+				if (!impl->is_alive(e.source) || !impl->is_alive(e.other))
+					continue;
+				impl->deliver_to_listeners(e);
+			}
+			impl->deliver_to_subscribers(e);
+		}
+		for (auto& e : impl->dispatched)
+			if (e.payload_ref != no_payload)
+				common::behaviors_manager->release_reference(e.payload_ref);
+		impl->dispatched.clear();
+	}
+	impl->purge_subscriptions();
+}
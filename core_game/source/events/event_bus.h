@@ -0,0 +1,127 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <cstdint>
+#include "source/entities/entity_registry.h"
+
+namespace entities
+{
+	class entity;
+	class scene;
+
+	namespace components
+	{
+		class behavior;
+	}
+}
+
+namespace events
+{
+	/*
+		event_type
+		types of the events delivered by the event bus
+	*/
+	enum class event_type
+	{
+		collide, overlap, input_action, scene_loaded, custom
+	};
+
+	/*
+		event_bus
+		queues engine and lua events and delivers them in a single dispatch pass after physics
+		events go only to the behaviors of the involved entities and to lua callbacks subscribed to their channel
+	*/
+	class event_bus
+	{
+	private:
+		struct implementation;
+		implementation* impl;
+	public:
+		/*
+			max_dispatch_rounds
+			events emitted during dispatch are delivered in the same dispatch, up to this amount of rounds
+			remaining events wait for the next frame
+		*/
+		static constexpr int max_dispatch_rounds = 4;
+
+		event_bus();
+		~event_bus();
+		/*
+			clear
+			drops queued events and subscriptions without releasing their lua references
+			called before the lua state is closed
+		*/
+		void clear();
+		/*
+			register_listener
+			behavior component receives on_collide and on_overlap of its owner
+			called when behavior component is attached
+		*/
+		void register_listener(entities::entity* entity, entities::components::behavior* listener);
+		/*
+			unregister_listener
+			called by the behavior component destructor
+		*/
+		void unregister_listener(entities::entity* entity, entities::components::behavior* listener);
+		/*
+			emit_collide, emit_overlap
+			queues the event for both entities,
+			nothing is queued if none of them has listeners and the channel has no subscribers
+		*/
+		void emit_collide(entities::entity_handle entity, entities::entity_handle other);
+		void emit_overlap(entities::entity_handle entity, entities::entity_handle other);
+		/*
+			emit_input_action
+			queues change of the action mapping state
+		*/
+		void emit_input_action(const std::string& action, bool pressed);
+		/*
+			emit_scene_loaded
+			queues creation of the scene
+		*/
+		void emit_scene_loaded(uint32_t scene_name);
+		/*
+			emit_custom
+			queues lua event, the bus takes ownership of the payload reference
+			-l-
+			[payload_ref] lua registry reference of the event value
+			[source]	  entity the event is about, may be empty
+		*/
+		void emit_custom(uint32_t channel, int payload_ref, entities::entity_handle source);
+		/*
+			subscribe
+			lua callback will be called with events of the channel,
+			the subscription belongs to the self of the current frame and ends with it
+			-l-
+			[callback_ref]	lua registry reference of the callback, the bus takes its ownership
+			[source]		only events about this entity are delivered, if set
+			[return value]	subscription id
+		*/
+		uint64_t subscribe(uint32_t channel, int callback_ref, entities::entity_handle source, bool has_source);
+		/*
+			unsubscribe
+		*/
+		void unsubscribe(uint64_t id);
+		/*
+			unsubscribe_scene
+			removes subscriptions made in the context of the scene
+			called by the scene destructor
+		*/
+		void unsubscribe_scene(entities::scene* scene);
+		/*
+			has_subscribers
+			returns true if any lua callback is subscribed to the channel
+		*/
+		bool has_subscribers(uint32_t channel);
+		/*
+			dispatch
+			delivers queued events
+		*/
+		void dispatch();
+	};
+
+	/*
+		channels of the engine events
+	*/
+	uint32_t get_channel(event_type type);
+}
@@ -0,0 +1,177 @@
+#include "file_watcher.h"
+
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifndef __linux__
+//how often are the files write times compared
+constexpr auto scan_interval = std::chrono::milliseconds(500);
+#endif
+
+std::string filesystem::normalize_path(const std::string& path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+struct filesystem::file_watcher::implementation
+{
+	std::string directory;
+	bool watching = false;
+
+#ifdef __linux__
+	int inotify_fd = -1;
+	//watch descriptor to watched directory path
+	std::unordered_map<int, std::string> watched_directories;
+
+	void add_directory(const std::string& path)
+	{
+		int wd = inotify_add_watch(inotify_fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (wd < 0)
+			return;
+		watched_directories[wd] = path;
+
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(path, ec))
+			if (entry.is_directory())
+				add_directory(entry.path().generic_string());
+	}
+
+	void close_watch()
+	{
+		if (inotify_fd != -1)
+			close(inotify_fd);
+		inotify_fd = -1;
+		watched_directories.clear();
+	}
+#else
+	std::unordered_map<std::string, std::filesystem::file_time_type> write_times;
+	std::chrono::steady_clock::time_point last_scan;
+
+	/*
+		scan
+		updates write_times, puts files whose write time changed to modified
+		modified may be nullptr
+	*/
+	void scan(std::unordered_set<std::string>* modified)
+	{
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, ec))
+		{
+			if (!entry.is_regular_file(ec))
+				continue;
+
+			auto time = entry.last_write_time(ec);
+			std::string path = normalize_path(entry.path().generic_string());
+
+			auto itr = write_times.find(path);
+			if (itr == write_times.end())
+			{
+				write_times.insert({ path, time });
+				if (modified != nullptr)
+					modified->insert(path);
+			}
+			else if (itr->second != time)
+			{
+				itr->second = time;
+				if (modified != nullptr)
+					modified->insert(path);
+			}
+		}
+		last_scan = std::chrono::steady_clock::now();
+	}
+#endif
+};
+
+filesystem::file_watcher::file_watcher()
+{
+	impl = new implementation;
+}
+
+filesystem::file_watcher::~file_watcher()
+{
+	stop();
+	delete impl;
+}
+
+void filesystem::file_watcher::watch(const std::string& directory)
+{
+	stop();
+	impl->directory = directory;
+	impl->watching = true;
+
+#ifdef __linux__
+	impl->inotify_fd = inotify_init1(IN_NONBLOCK);
+	if (impl->inotify_fd < 0)
+	{
+		impl->watching = false;
+		return;
+	}
+	impl->add_directory(directory);
+#else
+	impl->scan(nullptr);
+#endif
+}
+
+void filesystem::file_watcher::stop()
+{
+	impl->watching = false;
+#ifdef __linux__
+	impl->close_watch();
+#else
+	impl->write_times.clear();
+#endif
+}
+
+bool filesystem::file_watcher::is_watching()
+{
+	return impl->watching;
+}
+
+std::vector<std::string> filesystem::file_watcher::poll()
+{
+	if (!impl->watching)
+		return {};
+
+	std::unordered_set<std::string> modified;
+
+#ifdef __linux__
+	alignas(inotify_event) char buffer[4096];
+	while (true)
+	{
+		ssize_t length = read(impl->inotify_fd, buffer, sizeof(buffer));
+		if (length <= 0)
+			break;
+
+		for (char* ptr = buffer; ptr < buffer + length;)
+		{
+			auto event = reinterpret_cast<inotify_event*>(ptr);
+			ptr += sizeof(inotify_event) + event->len;
+
+			auto dir = impl->watched_directories.find(event->wd);
+			if (dir == impl->watched_directories.end() || event->len == 0)
+				continue;
+
+			std::string path = dir->second + '/' + event->name;
+			if (event->mask & IN_ISDIR)
+			{
+				impl->add_directory(path);
+				continue;
+			}
+			modified.insert(normalize_path(path));
+		}
+	}
+#else
+	if (std::chrono::steady_clock::now() - impl->last_scan < scan_interval)
+		return {};
+	impl->scan(&modified);
+#endif
+
+	return { modified.begin(), modified.end() };
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace filesystem
+{
+	/*
+		file_watcher
+		watches directory (with all of its subdirectories) for modified files
+		on linux uses inotify, on other platforms compares files last write times
+	*/
+	class file_watcher
+	{
+		struct implementation;
+		implementation* impl;
+	public:
+		file_watcher();
+		~file_watcher();
+		/*
+			watch
+			starts watching given directory
+			stops watching previously watched directory
+		*/
+		void watch(const std::string& directory);
+		/*
+			stop
+			stops watching current directory
+		*/
+		void stop();
+		/*
+			is_watching
+			returns true if any directory is being watched
+		*/
+		bool is_watching();
+		/*
+			poll
+			returns normalized absolute paths of files modified since the last poll
+			never blocks
+		*/
+		std::vector<std::string> poll();
+	};
+
+	/*
+		normalize_path
+		returns path in the form returned by file_watcher::poll
+		so paths from different sources can be compared
+	*/
+	std::string normalize_path(const std::string& path);
+}
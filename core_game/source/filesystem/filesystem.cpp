@@ -1,32 +1,37 @@
 #include "filesystem.h"
+#include "mounts.h"
 #include "source/common/crash.h"
 #include "include/stb/stb_image.h"
 #include <filesystem>
-
-static std::string mod_assets_path;
-static std::string core_assets_path;
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 static std::string mods_path;
 
 static std::string saved_path;
 static bool saved_path_enabled = false;
 
-static std::string active_path;
-static bool acitve_path_enabled = false;
+//active directory is set per thread, so loaders running on other threads are not affected
+static thread_local std::string active_path;
+static thread_local bool acitve_path_enabled = false;
 
 void filesystem::set_mod_assets_directory(std::string path)
 {
-	mod_assets_path = path;
+	mount_package_directory("mod", path);
 }
 
 void filesystem::set_core_assets_directory(std::string path)
 {
-	core_assets_path = path;
+	mount_package_directory("core", path);
 }
 
 void filesystem::set_saved_directory(std::string path)
 {
 	saved_path = path;
+	unmount_package("saved");
+	mount_package("saved", create_loose_mount(path));
 }
 
 void filesystem::set_saved_directory_enabled(bool enabled)
@@ -63,40 +68,45 @@ std::string filesystem::get_owning_folder(std::string path)
 	return owning_folder;
 }
 
-std::string filesystem::get_global_path(std::string path)
+std::string filesystem::resolve_path(std::string path)
 {
 	int split_index = static_cast<int>(path.find('/'));
 	std::string package = path.substr(0, split_index);
-	if (package == "mod")
-		return  mod_assets_path + path.substr(split_index, path.size());
-	else if (package == "core")
-		return core_assets_path + path.substr(split_index, path.size());
+	if (package == "mod" || package == "core")
+		return path;
 	else if (package == "$" && acitve_path_enabled)
-		return  get_global_path(active_path + path.substr(split_index, path.size()));
+		return resolve_path(active_path + path.substr(split_index, path.size()));
 	else if (package == "saved" && saved_path_enabled)
-		return  saved_path + path.substr(split_index, path.size());
-	error_handling::crash(error_handling::error_source::core, "[filesystem::get_global_path]",
+		return path;
+	error_handling::crash(error_handling::error_source::core, "[filesystem::resolve_path]",
 		"Unknown/Unavaible package: " + package);
 	return "";
 }
 
-bool filesystem::file_exists(std::string path)
+std::string filesystem::get_global_path(std::string path)
 {
-	return std::filesystem::exists(filesystem::get_global_path(path));
+	std::string global_path = get_mounted_loose_path(resolve_path(path));
+	if (global_path.empty())
+		error_handling::crash(error_handling::error_source::core, "[filesystem::get_global_path]",
+			"Package isn't mounted as a directory: " + path);
+	return global_path;
 }
 
-std::fstream filesystem::load_file(std::string path)
+bool filesystem::file_exists(std::string path)
 {
-	std::string global_path = filesystem::get_global_path(path);
+	return mounted_file_exists(resolve_path(path));
+}
 
-	std::fstream file;
-	file.open(global_path);
+std::string filesystem::load_file_data(std::string path)
+{
+	std::string resolved_path = resolve_path(path);
 
-	if (file.fail())
-		error_handling::crash(error_handling::error_source::core, "[filesystem::load_file]", 
-			"No such file: \n" + path + "\n" + global_path);
+	std::string data;
+	if (!read_mounted_file(resolved_path, data))
+		error_handling::crash(error_handling::error_source::core, "[filesystem::load_file_data]", 
+			"No such file: \n" + path + "\n" + resolved_path);
 
-	return file;
+	return data;
 }
 
 std::fstream filesystem::create_file(std::string path)
@@ -194,19 +204,138 @@ std::unique_ptr<filesystem::image_file> filesystem::load_image(std::string path)
 	std::unique_ptr<image_file> file = std::make_unique<image_file>();
 	stbi_set_flip_vertically_on_load(true);
 
-	file->image_source_pointer = stbi_load(filesystem::get_global_path(path).c_str(),
+	std::string data = load_file_data(path);
+	file->image_source_pointer = stbi_load_from_memory(
+		reinterpret_cast<const stbi_uc*>(data.data()),
+		static_cast<int>(data.size()),
 		&file->width,
 		&file->height, 
 		&file->color_channels, 
 	0);
 
 	if (file->image_source_pointer == nullptr)
-		error_handling::crash(error_handling::error_source::core, "[filesystem::load_file]",
-			"No such image: \n" + path + "\n" + filesystem::get_global_path(path));
+		error_handling::crash(error_handling::error_source::core, "[filesystem::load_image]",
+			"Invalid image: \n" + path);
 
 	return file;
 }
 
+void filesystem::load_images(const std::vector<std::string>& paths,
+	const std::function<void(size_t index, std::unique_ptr<image_file> image)>& on_loaded)
+{
+	std::vector<std::unique_ptr<image_file>> images(paths.size());
+	std::vector<bool> decoded(paths.size(), false);
+	std::mutex mutex;
+	std::condition_variable image_decoded;
+	std::atomic<size_t> next_image = 0;
+	std::atomic<bool> aborted = false;
+
+	//flipping is done by the caller, while copying the rows
+	stbi_set_flip_vertically_on_load(false);
+
+	auto decode = [&]()
+	{
+		while (!aborted)
+		{
+			size_t index = next_image++;
+			if (index >= paths.size())
+				return;
+
+			auto file = std::make_unique<image_file>();
+			file->bottom_to_top = false;
+
+			//mounts are thread safe, so files are read by the workers as well
+			std::string data;
+			if (read_mounted_file(paths[index], data))
+				file->image_source_pointer = stbi_load_from_memory(
+					reinterpret_cast<const stbi_uc*>(data.data()),
+					static_cast<int>(data.size()),
+					&file->width,
+					&file->height,
+					&file->color_channels,
+				0);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			images[index] = std::move(file);
+			decoded[index] = true;
+			image_decoded.notify_one();
+		}
+	};
+
+	size_t workers_count = std::thread::hardware_concurrency();
+	if (workers_count == 0)
+		workers_count = 1;
+	if (workers_count > paths.size())
+		workers_count = paths.size();
+
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < workers_count; i++)
+		workers.emplace_back(decode);
+
+	auto join_workers = [&]()
+	{
+		for (auto& worker : workers)
+			worker.join();
+		stbi_set_flip_vertically_on_load(true);
+	};
+
+	try
+	{
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			std::unique_ptr<image_file> image;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				image_decoded.wait(lock, [&]() { return decoded[i]; });
+				image = std::move(images[i]);
+			}
+
+			if (image->image_source_pointer == nullptr)
+				error_handling::crash(error_handling::error_source::core, "[filesystem::load_images]",
+					"Missing/Invalid image: \n" + paths[i]);
+
+			on_loaded(i, std::move(image));
+		}
+	}
+	catch (...)
+	{
+		aborted = true;
+		join_workers();
+		throw;
+	}
+
+	join_workers();
+}
+
+//engine cache folder inside the saved directory
+static std::string get_cache_path(const std::string& name)
+{
+	return saved_path + "/.cache/" + name;
+}
+
+bool filesystem::load_cache_file(const std::string& name, std::string& data)
+{
+	std::ifstream file(get_cache_path(name), std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	data.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(&data[0], data.size());
+	return !file.fail();
+}
+
+void filesystem::save_cache_file(const std::string& name, const std::string& data)
+{
+	std::filesystem::path path = get_cache_path(name);
+	std::error_code ec;
+	std::filesystem::create_directories(path.parent_path(), ec);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (file.is_open())
+		file.write(data.data(), data.size());
+}
+
 std::string filesystem::get_global_mod_path(std::string mod_name)
 {
 	return mods_path + '/' + mod_name + '/';
@@ -2,6 +2,9 @@
 
 #include <fstream>
 #include <vector>
+#include <string>
+#include <memory>
+#include <functional>
 
 namespace filesystem
 {
@@ -54,8 +57,16 @@ namespace filesystem
 	*/
 	std::string get_owning_folder(std::string path);
 	/*
+	resolve_path
+	replaces "$/" prefix with the active assets directory
+	and checks if the package is avaible
+	resolved paths can be used from any thread
+	*/
+	std::string resolve_path(std::string path);
+	/*
 	get_global_path
-	returns absolute path of the given path
+	returns absolute path of the given path in the directory mounted for its package
+	packed files have no global path
 	*/
 	std::string get_global_path(std::string path);
 	/*
@@ -64,10 +75,10 @@ namespace filesystem
 	*/
 	bool file_exists(std::string relative_path_with_extension);
 	/*
-	load_file
-	loads file
+	load_file_data
+	reads whole file from the mounted directory or pack
 	*/
-	std::fstream load_file(std::string relative_path_with_extension);
+	std::string load_file_data(std::string relative_path_with_extension);
 	/*
 	create_file
 	creates file
@@ -93,6 +104,8 @@ namespace filesystem
 	{
 		unsigned char* image_source_pointer = nullptr;
 		int width, height, color_channels = 0;
+		//if true rows are stored from the bottom one, as opengl expects them
+		bool bottom_to_top = true;
 		~image_file();
 	};
 	/*
@@ -101,6 +114,31 @@ namespace filesystem
 	*/
 	std::unique_ptr<image_file> load_image(std::string path_with_extension);
 	/*
+	load_images
+	decodes images on worker threads
+	calls on_loaded on the calling thread for every image, in the order of given paths, as soon as it is decoded
+	rows of returned images are stored from the top one, so they can be flipped while being copied
+	-l-
+	[resolved_paths_with_extension] paths of the images returned by resolve_path
+	*/
+	void load_images(const std::vector<std::string>& resolved_paths_with_extension,
+		const std::function<void(size_t index, std::unique_ptr<image_file> image)>& on_loaded);
+	/*
+	load_cache_file
+	reads file saved by save_cache_file
+	cache files are stored in the saved directory, but aren't avaible to mods
+	returns false if there is no such file
+	-l-
+	[name] path relative to the cache folder
+	*/
+	bool load_cache_file(const std::string& name, std::string& data);
+	/*
+	save_cache_file
+	saves binary file to the cache folder, creating needed folders
+	failures are ignored, as cache files are optional
+	*/
+	void save_cache_file(const std::string& name, const std::string& data);
+	/*
 	get_global_mod_path
 	returns absolute path to the given mod
 	*/
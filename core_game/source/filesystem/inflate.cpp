@@ -0,0 +1,325 @@
+#include "inflate.h"
+
+#include <cstdint>
+
+/*
+	minimal deflate decoder (rfc 1951),
+	huffman codes are decoded canonically, one bit at a time
+*/
+
+constexpr int max_bits = 15;
+constexpr int max_literal_codes = 288;
+constexpr int max_distance_codes = 30;
+
+struct huffman
+{
+	//number of codes of each length
+	uint16_t counts[max_bits + 1];
+	//symbols ordered by code
+	uint16_t symbols[max_literal_codes];
+};
+
+struct bit_reader
+{
+	const uint8_t* data;
+	size_t size;
+	size_t position = 0;
+	uint32_t buffer = 0;
+	int buffered_bits = 0;
+	bool overflow = false;
+
+	uint32_t bits(int count)
+	{
+		while (buffered_bits < count)
+		{
+			if (position == size)
+			{
+				overflow = true;
+				return 0;
+			}
+			buffer |= static_cast<uint32_t>(data[position++]) << buffered_bits;
+			buffered_bits += 8;
+		}
+		uint32_t value = buffer & ((1u << count) - 1);
+		buffer >>= count;
+		buffered_bits -= count;
+		return value;
+	}
+
+	void align_to_byte()
+	{
+		buffer = 0;
+		buffered_bits = 0;
+	}
+};
+
+//returns false if lengths do not form a valid code
+static bool build_huffman(huffman& h, const uint8_t* lengths, int codes_count)
+{
+	for (auto& count : h.counts)
+		count = 0;
+	for (int i = 0; i < codes_count; i++)
+		h.counts[lengths[i]]++;
+
+	if (h.counts[0] == codes_count)
+		return true;
+
+	int left = 1;
+	for (int length = 1; length <= max_bits; length++)
+	{
+		left <<= 1;
+		left -= h.counts[length];
+		if (left < 0)
+			return false;
+	}
+
+	uint16_t offsets[max_bits + 1];
+	offsets[1] = 0;
+	for (int length = 1; length < max_bits; length++)
+		offsets[length + 1] = offsets[length] + h.counts[length];
+
+	for (int i = 0; i < codes_count; i++)
+		if (lengths[i] != 0)
+			h.symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+	return true;
+}
+
+//returns -1 on error
+static int decode_symbol(bit_reader& reader, const huffman& h)
+{
+	int code = 0, first = 0, index = 0;
+	for (int length = 1; length <= max_bits; length++)
+	{
+		code |= static_cast<int>(reader.bits(1));
+		if (reader.overflow)
+			return -1;
+		int count = h.counts[length];
+		if (code - count < first)
+			return h.symbols[index + (code - first)];
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+	return -1;
+}
+
+static const uint16_t length_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t length_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distance_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distance_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static bool inflate_codes(bit_reader& reader, std::string& output, const huffman& literals, const huffman& distances)
+{
+	while (true)
+	{
+		int symbol = decode_symbol(reader, literals);
+		if (symbol < 0)
+			return false;
+
+		if (symbol < 256)
+		{
+			output.push_back(static_cast<char>(symbol));
+			continue;
+		}
+		if (symbol == 256)
+			return true;
+
+		symbol -= 257;
+		if (symbol >= 29)
+			return false;
+		size_t length = length_base[symbol] + reader.bits(length_extra[symbol]);
+
+		int distance_symbol = decode_symbol(reader, distances);
+		if (distance_symbol < 0 || distance_symbol >= 30)
+			return false;
+		size_t distance = distance_base[distance_symbol] + reader.bits(distance_extra[distance_symbol]);
+		if (reader.overflow || distance > output.size())
+			return false;
+
+		//copies may overlap the output
+		size_t from = output.size() - distance;
+		for (size_t i = 0; i < length; i++)
+			output.push_back(output[from + i]);
+	}
+}
+
+static bool inflate_stored(bit_reader& reader, std::string& output)
+{
+	reader.align_to_byte();
+	if (reader.size - reader.position < 4)
+		return false;
+	const uint8_t* header = reader.data + reader.position;
+	uint16_t length = header[0] | (header[1] << 8);
+	uint16_t complement = header[2] | (header[3] << 8);
+	if (length != static_cast<uint16_t>(~complement))
+		return false;
+	reader.position += 4;
+
+	if (reader.size - reader.position < length)
+		return false;
+	output.append(reinterpret_cast<const char*>(reader.data + reader.position), length);
+	reader.position += length;
+	return true;
+}
+
+static bool inflate_fixed(bit_reader& reader, std::string& output)
+{
+	static huffman literals, distances;
+	static bool built = false;
+	if (!built)
+	{
+		uint8_t lengths[max_literal_codes];
+		int i = 0;
+		for (; i < 144; i++) lengths[i] = 8;
+		for (; i < 256; i++) lengths[i] = 9;
+		for (; i < 280; i++) lengths[i] = 7;
+		for (; i < max_literal_codes; i++) lengths[i] = 8;
+		build_huffman(literals, lengths, max_literal_codes);
+
+		for (i = 0; i < max_distance_codes; i++) lengths[i] = 5;
+		build_huffman(distances, lengths, max_distance_codes);
+		built = true;
+	}
+	return inflate_codes(reader, output, literals, distances);
+}
+
+static bool inflate_dynamic(bit_reader& reader, std::string& output)
+{
+	static const uint8_t code_lengths_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	int literals_count = static_cast<int>(reader.bits(5)) + 257;
+	int distances_count = static_cast<int>(reader.bits(5)) + 1;
+	int code_lengths_count = static_cast<int>(reader.bits(4)) + 4;
+	if (reader.overflow || literals_count > max_literal_codes || distances_count > max_distance_codes)
+		return false;
+
+	uint8_t lengths[max_literal_codes + max_distance_codes] = {};
+	for (int i = 0; i < code_lengths_count; i++)
+		lengths[code_lengths_order[i]] = static_cast<uint8_t>(reader.bits(3));
+
+	huffman code_lengths;
+	if (!build_huffman(code_lengths, lengths, 19))
+		return false;
+
+	int index = 0;
+	while (index < literals_count + distances_count)
+	{
+		int symbol = decode_symbol(reader, code_lengths);
+		if (symbol < 0)
+			return false;
+
+		if (symbol < 16)
+		{
+			lengths[index++] = static_cast<uint8_t>(symbol);
+			continue;
+		}
+
+		uint8_t repeated = 0;
+		int repeat;
+		if (symbol == 16)
+		{
+			if (index == 0)
+				return false;
+			repeated = lengths[index - 1];
+			repeat = 3 + static_cast<int>(reader.bits(2));
+		}
+		else if (symbol == 17)
+			repeat = 3 + static_cast<int>(reader.bits(3));
+		else
+			repeat = 11 + static_cast<int>(reader.bits(7));
+
+		if (reader.overflow || index + repeat > literals_count + distances_count)
+			return false;
+		while (repeat--)
+			lengths[index++] = repeated;
+	}
+
+	//end of block code is required
+	if (lengths[256] == 0)
+		return false;
+
+	huffman literals, distances;
+	if (!build_huffman(literals, lengths, literals_count)
+		|| !build_huffman(distances, lengths + literals_count, distances_count))
+		return false;
+
+	return inflate_codes(reader, output, literals, distances);
+}
+
+static bool inflate_raw(bit_reader& reader, std::string& output)
+{
+	bool last_block = false;
+	while (!last_block)
+	{
+		last_block = reader.bits(1) != 0;
+		uint32_t type = reader.bits(2);
+		if (reader.overflow)
+			return false;
+
+		bool success = false;
+		switch (type)
+		{
+		case 0: success = inflate_stored(reader, output); break;
+		case 1: success = inflate_fixed(reader, output); break;
+		case 2: success = inflate_dynamic(reader, output); break;
+		default: break;
+		}
+		if (!success)
+			return false;
+	}
+	return true;
+}
+
+bool filesystem::inflate(const char* data, size_t size, std::string& output, size_t expected_size)
+{
+	auto bytes = reinterpret_cast<const uint8_t*>(data);
+	size_t header_size = 0;
+
+	if (size >= 10 && bytes[0] == 0x1F && bytes[1] == 0x8B)
+	{
+		//gzip
+		if (bytes[2] != 8)
+			return false;
+		uint8_t flags = bytes[3];
+		header_size = 10;
+		if (flags & 0x04)	//extra field
+		{
+			if (size < header_size + 2)
+				return false;
+			header_size += 2 + (bytes[header_size] | (bytes[header_size + 1] << 8));
+		}
+		if (flags & 0x08)	//file name
+			while (header_size < size && bytes[header_size++] != 0);
+		if (flags & 0x10)	//comment
+			while (header_size < size && bytes[header_size++] != 0);
+		if (flags & 0x02)	//header crc
+			header_size += 2;
+	}
+	else if (size >= 2 && (bytes[0] & 0x0F) == 8 && ((bytes[0] << 8) | bytes[1]) % 31 == 0)
+	{
+		//zlib, preset dictionaries are not supported
+		if (bytes[1] & 0x20)
+			return false;
+		header_size = 2;
+	}
+	else
+		return false;
+
+	if (header_size >= size)
+		return false;
+
+	output.clear();
+	output.reserve(expected_size);
+
+	bit_reader reader{ bytes + header_size, size - header_size };
+	return inflate_raw(reader, output);
+}
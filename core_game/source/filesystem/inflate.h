@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+
+namespace filesystem
+{
+	/*
+		inflate
+		decompresses zlib or gzip stream (detected from the header)
+		returns false if the stream is corrupted
+		-l-
+		[expected_size] size hint used to reserve the output
+	*/
+	bool inflate(const char* data, size_t size, std::string& output, size_t expected_size = 0);
+}
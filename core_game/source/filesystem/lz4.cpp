@@ -0,0 +1,158 @@
+#include "lz4.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//the lz4 block format requires the last 5 bytes to be literals
+//and the last match to start at least 12 bytes before the end of the block
+constexpr size_t last_literals = 5;
+constexpr size_t match_safe_distance = 12;
+constexpr size_t min_match = 4;
+constexpr size_t max_offset = 65535;
+constexpr int hash_bits = 16;
+
+static uint32_t read_u32(const char* ptr)
+{
+	uint32_t value;
+	std::memcpy(&value, ptr, sizeof(value));
+	return value;
+}
+
+static uint32_t hash_sequence(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - hash_bits);
+}
+
+static void write_length(std::string& out, size_t length)
+{
+	while (length >= 255)
+	{
+		out.push_back(static_cast<char>(255));
+		length -= 255;
+	}
+	out.push_back(static_cast<char>(length));
+}
+
+static void write_sequence(std::string& out, const char* literals, size_t literals_length, size_t offset, size_t match_length)
+{
+	size_t match_token = match_length >= min_match ? match_length - min_match : 0;
+	uint8_t token = static_cast<uint8_t>(
+		((literals_length < 15 ? literals_length : 15) << 4) | (match_token < 15 ? match_token : 15));
+	out.push_back(static_cast<char>(token));
+
+	if (literals_length >= 15)
+		write_length(out, literals_length - 15);
+	out.append(literals, literals_length);
+
+	//the last sequence has no match
+	if (match_length == 0)
+		return;
+
+	out.push_back(static_cast<char>(offset & 0xFF));
+	out.push_back(static_cast<char>((offset >> 8) & 0xFF));
+	if (match_token >= 15)
+		write_length(out, match_token - 15);
+}
+
+std::string filesystem::lz4::compress(const char* data, size_t size)
+{
+	std::string out;
+	out.reserve(size / 2 + 16);
+
+	size_t anchor = 0;
+	size_t position = 0;
+
+	if (size > match_safe_distance)
+	{
+		std::vector<uint32_t> table(size_t(1) << hash_bits, UINT32_MAX);
+		size_t match_limit = size - match_safe_distance;
+
+		while (position < match_limit)
+		{
+			uint32_t sequence = read_u32(data + position);
+			uint32_t& entry = table[hash_sequence(sequence)];
+			size_t candidate = entry;
+			entry = static_cast<uint32_t>(position);
+
+			if (candidate == UINT32_MAX || position - candidate > max_offset || read_u32(data + candidate) != sequence)
+			{
+				position++;
+				continue;
+			}
+
+			//extend the match, without entering the last literals
+			size_t match_length = min_match;
+			while (position + match_length < size - last_literals
+				&& data[candidate + match_length] == data[position + match_length])
+				match_length++;
+
+			write_sequence(out, data + anchor, position - anchor, position - candidate, match_length);
+			position += match_length;
+			anchor = position;
+		}
+	}
+
+	write_sequence(out, data + anchor, size - anchor, 0, 0);
+	return out;
+}
+
+bool filesystem::lz4::decompress(const char* block, size_t block_size, char* destination, size_t decompressed_size)
+{
+	const uint8_t* in = reinterpret_cast<const uint8_t*>(block);
+	const uint8_t* in_end = in + block_size;
+	size_t out = 0;
+
+	auto read_length = [&](size_t& length) -> bool
+	{
+		uint8_t byte;
+		do
+		{
+			if (in == in_end)
+				return false;
+			byte = *in++;
+			length += byte;
+		} while (byte == 255);
+		return true;
+	};
+
+	while (in < in_end)
+	{
+		uint8_t token = *in++;
+
+		size_t literals_length = token >> 4;
+		if (literals_length == 15 && !read_length(literals_length))
+			return false;
+		if (literals_length > static_cast<size_t>(in_end - in) || literals_length > decompressed_size - out)
+			return false;
+		std::memcpy(destination + out, in, literals_length);
+		in += literals_length;
+		out += literals_length;
+
+		//the last sequence ends after literals
+		if (in == in_end)
+			break;
+
+		if (in_end - in < 2)
+			return false;
+		size_t offset = in[0] | (in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > out)
+			return false;
+
+		size_t match_length = token & 0x0F;
+		if (match_length == 15 && !read_length(match_length))
+			return false;
+		match_length += min_match;
+		if (match_length > decompressed_size - out)
+			return false;
+
+		//matches may overlap the output, so copy byte by byte
+		char* match = destination + out - offset;
+		for (size_t i = 0; i < match_length; i++)
+			destination[out + i] = match[i];
+		out += match_length;
+	}
+
+	return out == decompressed_size;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+
+namespace filesystem
+{
+	namespace lz4
+	{
+		/*
+			compress
+			compresses data into a single lz4 block (without the frame header)
+		*/
+		std::string compress(const char* data, size_t size);
+		/*
+			decompress
+			decompresses single lz4 block
+			returns false if the block is corrupted or its decompressed size isn't equal to decompressed_size
+			-l-
+			[destination] buffer of at least decompressed_size bytes
+		*/
+		bool decompress(const char* block, size_t block_size, char* destination, size_t decompressed_size);
+	}
+}
@@ -0,0 +1,527 @@
+#include "mounts.h"
+#include "lz4.h"
+
+#include "source/common/crash.h"
+
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+
+/*
+	pack file layout, all numbers are little endian:
+	header:
+		char[8] magic "SGEPACK1"
+		uint32  compression (0 - none, 1 - lz4)
+		uint32  chunk size
+		uint32  entries count
+		uint32  chunks count
+		uint64  index offset
+	chunks data
+	index:
+		entries: uint16 path length, path, uint64 file size, uint32 first chunk
+		chunks:  uint64 offset, uint32 stored size
+	each file starts a new chunk, files chunks are stored one after another
+*/
+constexpr char pack_magic[8] = { 'S', 'G', 'E', 'P', 'A', 'C', 'K', '1' };
+constexpr uint32_t pack_chunk_size = 64 * 1024;
+constexpr size_t pack_header_size = 8 + 4 * 4 + 8;
+
+//how many bytes are read at once when reading small files from a pack
+constexpr size_t read_ahead_size = 1024 * 1024;
+
+enum class pack_compression : uint32_t
+{
+	none = 0, lz4 = 1
+};
+
+using clock_type = std::chrono::steady_clock;
+
+static uint64_t nanoseconds_since(clock_type::time_point start)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count();
+}
+
+//converts path to the form used in the packs index
+static std::string normalize_relative_path(const std::string& path)
+{
+	std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+	size_t start = normalized.find_first_not_of('/');
+	if (start == std::string::npos)
+		return "";
+	return normalized.substr(start);
+}
+
+struct loose_mount : public filesystem::mount
+{
+	std::string directory;
+
+	loose_mount(const std::string& _directory) : directory(_directory) {};
+
+	virtual bool exists(const std::string& path) override
+	{
+		std::error_code ec;
+		return std::filesystem::is_regular_file(get_loose_path(path), ec);
+	}
+
+	virtual bool read(const std::string& path, std::string& data, filesystem::file_stats& stats) override
+	{
+		auto start = clock_type::now();
+		std::ifstream file(get_loose_path(path), std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return false;
+		stats.opens++;
+		stats.open_nanoseconds += nanoseconds_since(start);
+
+		start = clock_type::now();
+		size_t size = static_cast<size_t>(file.tellg());
+		data.resize(size);
+		file.seekg(0);
+		//single read of the whole file, so the os can read ahead sequentially
+		file.read(&data[0], size);
+		stats.reads++;
+		stats.bytes_read += size;
+		stats.read_nanoseconds += nanoseconds_since(start);
+
+		return !file.fail();
+	}
+
+	virtual std::string get_loose_path(const std::string& path) override
+	{
+		if (path.empty() || path.front() == '/' || directory.empty() || directory.back() == '/')
+			return directory + path;
+		return directory + '/' + path;
+	}
+};
+
+struct pack_mount : public filesystem::mount
+{
+	struct entry
+	{
+		uint64_t size;
+		uint32_t first_chunk;
+	};
+
+	struct chunk
+	{
+		uint64_t offset;
+		uint32_t stored_size;
+	};
+
+	std::string pack_path;
+	pack_compression compression = pack_compression::none;
+	uint32_t chunk_size = pack_chunk_size;
+	uint64_t pack_size = 0;
+	std::unordered_map<std::string, entry> entries;
+	std::vector<chunk> chunks;
+
+	//guards file and the read ahead window
+	std::mutex file_mutex;
+	std::ifstream file;
+	std::vector<char> window;
+	uint64_t window_offset = 0;
+
+	pack_mount(const std::string& _pack_path) : pack_path(_pack_path)
+	{
+		file.open(pack_path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			error_handling::crash(error_handling::error_source::core, "[filesystem::create_pack_mount]",
+				"Cannot open pack: " + pack_path);
+		pack_size = static_cast<uint64_t>(file.tellg());
+
+		std::vector<char> header(pack_header_size);
+		if (!read_at(0, header.size(), header.data()) || std::memcmp(header.data(), pack_magic, sizeof(pack_magic)) != 0)
+			error_handling::crash(error_handling::error_source::core, "[filesystem::create_pack_mount]",
+				"Invalid pack: " + pack_path);
+
+		const char* ptr = header.data() + sizeof(pack_magic);
+		uint32_t entries_count, chunks_count;
+		uint64_t index_offset;
+		read_value(ptr, compression);
+		read_value(ptr, chunk_size);
+		read_value(ptr, entries_count);
+		read_value(ptr, chunks_count);
+		read_value(ptr, index_offset);
+
+		if (index_offset > pack_size || (compression != pack_compression::none && compression != pack_compression::lz4))
+			error_handling::crash(error_handling::error_source::core, "[filesystem::create_pack_mount]",
+				"Invalid pack: " + pack_path);
+
+		std::vector<char> index(static_cast<size_t>(pack_size - index_offset));
+		if (!read_at(index_offset, index.size(), index.data()))
+			error_handling::crash(error_handling::error_source::core, "[filesystem::create_pack_mount]",
+				"Corrupted pack: " + pack_path);
+
+		ptr = index.data();
+		const char* end = index.data() + index.size();
+		auto require = [&](size_t bytes)
+		{
+			if (static_cast<size_t>(end - ptr) < bytes)
+				error_handling::crash(error_handling::error_source::core, "[filesystem::create_pack_mount]",
+					"Corrupted pack index: " + pack_path);
+		};
+
+		//counts are checked against the index size before anything is allocated for them
+		constexpr size_t min_entry_size = sizeof(uint16_t) + sizeof(uint64_t) + sizeof(uint32_t);
+		constexpr size_t chunk_record_size = sizeof(uint64_t) + sizeof(uint32_t);
+		if (uint64_t(entries_count) * min_entry_size + uint64_t(chunks_count) * chunk_record_size > index.size())
+			error_handling::crash(error_handling::error_source::core, "[filesystem::create_pack_mount]",
+				"Corrupted pack index: " + pack_path);
+
+		entries.reserve(entries_count);
+		for (uint32_t i = 0; i < entries_count; i++)
+		{
+			uint16_t path_length;
+			require(sizeof(path_length));
+			read_value(ptr, path_length);
+			require(path_length + sizeof(uint64_t) + sizeof(uint32_t));
+			std::string path(ptr, path_length);
+			ptr += path_length;
+			entry e;
+			read_value(ptr, e.size);
+			read_value(ptr, e.first_chunk);
+			entries.insert({ std::move(path), e });
+		}
+
+		chunks.resize(chunks_count);
+		for (auto& c : chunks)
+		{
+			require(sizeof(c.offset) + sizeof(c.stored_size));
+			read_value(ptr, c.offset);
+			read_value(ptr, c.stored_size);
+		}
+	}
+
+	template<class T>
+	static void read_value(const char*& ptr, T& value)
+	{
+		std::memcpy(&value, ptr, sizeof(T));
+		ptr += sizeof(T);
+	}
+
+	/*
+		read_at
+		reads pack bytes, small reads are served from the read ahead window
+		which is refilled with read_ahead_size bytes starting at the requested offset,
+		reads of at least read_ahead_size bytes go straight to the destination
+		since they are already sequential and copying them through the window would only add a copy
+	*/
+	bool read_at(uint64_t offset, size_t size, char* destination)
+	{
+		if (offset + size > pack_size)
+			return false;
+
+		std::lock_guard<std::mutex> lock(file_mutex);
+
+		if (offset >= window_offset && offset + size <= window_offset + window.size())
+		{
+			std::memcpy(destination, window.data() + (offset - window_offset), size);
+			return true;
+		}
+
+		if (size >= read_ahead_size)
+		{
+			file.seekg(offset);
+			file.read(destination, size);
+			if (file.fail())
+			{
+				file.clear();
+				return false;
+			}
+			return true;
+		}
+
+		window.resize(static_cast<size_t>(std::min<uint64_t>(read_ahead_size, pack_size - offset)));
+		window_offset = offset;
+		file.seekg(offset);
+		file.read(window.data(), window.size());
+		if (file.fail())
+		{
+			file.clear();
+			window.clear();
+			return false;
+		}
+		std::memcpy(destination, window.data(), size);
+		return true;
+	}
+
+	const entry* find(const std::string& path)
+	{
+		auto itr = entries.find(normalize_relative_path(path));
+		if (itr == entries.end())
+			return nullptr;
+		return &itr->second;
+	}
+
+	virtual bool exists(const std::string& path) override
+	{
+		return find(path) != nullptr;
+	}
+
+	virtual bool read(const std::string& path, std::string& data, filesystem::file_stats& stats) override
+	{
+		auto start = clock_type::now();
+		auto e = find(path);
+		if (e == nullptr)
+			return false;
+		stats.opens++;
+		stats.open_nanoseconds += nanoseconds_since(start);
+
+		start = clock_type::now();
+		data.resize(static_cast<size_t>(e->size));
+
+		bool success = true;
+		if (compression == pack_compression::none)
+		{
+			//chunks of a file are stored one after another
+			if (e->size != 0)
+				success = e->first_chunk < chunks.size() && read_at(chunks[e->first_chunk].offset, data.size(), &data[0]);
+		}
+		else
+		{
+			std::vector<char> compressed;
+			uint64_t position = 0;
+			for (uint32_t i = e->first_chunk; position < e->size && success; i++)
+			{
+				if (i >= chunks.size())
+				{
+					success = false;
+					break;
+				}
+				size_t chunk_bytes = static_cast<size_t>(std::min<uint64_t>(chunk_size, e->size - position));
+				compressed.resize(chunks[i].stored_size);
+				success = read_at(chunks[i].offset, compressed.size(), compressed.data())
+					&& filesystem::lz4::decompress(compressed.data(), compressed.size(), &data[position], chunk_bytes);
+				position += chunk_bytes;
+			}
+		}
+
+		if (!success)
+			error_handling::crash(error_handling::error_source::core, "[filesystem::read_file]",
+				"Corrupted file: " + path + " in pack: " + pack_path);
+
+		stats.reads++;
+		stats.bytes_read += data.size();
+		stats.read_nanoseconds += nanoseconds_since(start);
+		return true;
+	}
+};
+
+std::unique_ptr<filesystem::mount> filesystem::create_loose_mount(const std::string& directory)
+{
+	return std::make_unique<loose_mount>(directory);
+}
+
+std::unique_ptr<filesystem::mount> filesystem::create_pack_mount(const std::string& pack_path)
+{
+	return std::make_unique<pack_mount>(pack_path);
+}
+
+template<class T>
+static void write_value(std::ostream& out, const T& value)
+{
+	out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void filesystem::create_pack(const std::string& directory, const std::string& pack_path, bool compress)
+{
+	std::vector<std::string> files;
+	auto pack_file = std::filesystem::weakly_canonical(pack_path);
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+		if (entry.is_regular_file() && std::filesystem::weakly_canonical(entry.path()) != pack_file)
+			files.push_back(std::filesystem::relative(entry.path(), directory).generic_string());
+
+	std::ofstream out(pack_path, std::ios::binary);
+	if (!out.is_open())
+		error_handling::crash(error_handling::error_source::core, "[filesystem::create_pack]",
+			"Cannot create pack: " + pack_path);
+
+	//header is written again once the index offset is known
+	out.write(std::string(pack_header_size, '\0').data(), pack_header_size);
+
+	struct entry
+	{
+		std::string path;
+		uint64_t size;
+		uint32_t first_chunk;
+	};
+	std::vector<entry> entries;
+	std::vector<std::pair<uint64_t, uint32_t>> chunks;
+
+	for (auto& path : files)
+	{
+		std::ifstream file(directory + '/' + path, std::ios::binary | std::ios::ate);
+		std::string data(static_cast<size_t>(file.tellg()), '\0');
+		file.seekg(0);
+		file.read(&data[0], data.size());
+
+		entries.push_back({ path, data.size(), static_cast<uint32_t>(chunks.size()) });
+
+		for (size_t position = 0; position < data.size(); position += pack_chunk_size)
+		{
+			size_t size = std::min<size_t>(pack_chunk_size, data.size() - position);
+			chunks.push_back({ static_cast<uint64_t>(out.tellp()), 0 });
+			if (compress)
+			{
+				std::string block = lz4::compress(data.data() + position, size);
+				out.write(block.data(), block.size());
+				chunks.back().second = static_cast<uint32_t>(block.size());
+			}
+			else
+			{
+				out.write(data.data() + position, size);
+				chunks.back().second = static_cast<uint32_t>(size);
+			}
+		}
+	}
+
+	uint64_t index_offset = static_cast<uint64_t>(out.tellp());
+	for (auto& e : entries)
+	{
+		write_value(out, static_cast<uint16_t>(e.path.size()));
+		out.write(e.path.data(), e.path.size());
+		write_value(out, e.size);
+		write_value(out, e.first_chunk);
+	}
+	for (auto& c : chunks)
+	{
+		write_value(out, c.first);
+		write_value(out, c.second);
+	}
+
+	out.seekp(0);
+	out.write(pack_magic, sizeof(pack_magic));
+	write_value(out, compress ? pack_compression::lz4 : pack_compression::none);
+	write_value(out, pack_chunk_size);
+	write_value(out, static_cast<uint32_t>(entries.size()));
+	write_value(out, static_cast<uint32_t>(chunks.size()));
+	write_value(out, index_offset);
+
+	if (out.fail())
+		error_handling::crash(error_handling::error_source::core, "[filesystem::create_pack]",
+			"Cannot write pack: " + pack_path);
+}
+
+static std::shared_mutex mounts_mutex;
+static std::unordered_map<std::string, std::vector<std::unique_ptr<filesystem::mount>>> mounts;
+
+static std::mutex stats_mutex;
+static std::unordered_map<std::string, filesystem::file_stats> files_stats;
+
+void filesystem::mount_package(const std::string& package, std::unique_ptr<mount> mount)
+{
+	std::unique_lock<std::shared_mutex> lock(mounts_mutex);
+	mounts[package].push_back(std::move(mount));
+}
+
+void filesystem::unmount_package(const std::string& package)
+{
+	std::unique_lock<std::shared_mutex> lock(mounts_mutex);
+	mounts.erase(package);
+}
+
+void filesystem::mount_package_directory(const std::string& package, const std::string& directory)
+{
+	unmount_package(package);
+	mount_package(package, create_loose_mount(directory));
+
+	std::string pack_path = directory + '/' + package + ".pack";
+	std::error_code ec;
+	if (std::filesystem::is_regular_file(pack_path, ec))
+		mount_package(package, create_pack_mount(pack_path));
+}
+
+//splits "package/path" into package and path relative to it
+static void split_path(const std::string& path, std::string& package, std::string& relative)
+{
+	size_t split_index = path.find('/');
+	if (split_index == std::string::npos)
+	{
+		package = path;
+		relative = "";
+		return;
+	}
+	package = path.substr(0, split_index);
+	relative = path.substr(split_index + 1);
+}
+
+bool filesystem::read_mounted_file(const std::string& path, std::string& data)
+{
+	std::string package, relative;
+	split_path(path, package, relative);
+
+	file_stats stats;
+	bool found = false;
+	{
+		std::shared_lock<std::shared_mutex> lock(mounts_mutex);
+		auto itr = mounts.find(package);
+		if (itr == mounts.end())
+			return false;
+		for (auto& mount : itr->second)
+			if (mount->read(relative, data, stats))
+			{
+				found = true;
+				break;
+			}
+	}
+
+	if (found)
+	{
+		std::lock_guard<std::mutex> lock(stats_mutex);
+		auto& file = files_stats[path];
+		file.opens += stats.opens;
+		file.reads += stats.reads;
+		file.bytes_read += stats.bytes_read;
+		file.open_nanoseconds += stats.open_nanoseconds;
+		file.read_nanoseconds += stats.read_nanoseconds;
+	}
+	return found;
+}
+
+bool filesystem::mounted_file_exists(const std::string& path)
+{
+	std::string package, relative;
+	split_path(path, package, relative);
+
+	std::shared_lock<std::shared_mutex> lock(mounts_mutex);
+	auto itr = mounts.find(package);
+	if (itr == mounts.end())
+		return false;
+	for (auto& mount : itr->second)
+		if (mount->exists(relative))
+			return true;
+	return false;
+}
+
+std::string filesystem::get_mounted_loose_path(const std::string& path)
+{
+	std::string package, relative;
+	split_path(path, package, relative);
+
+	std::shared_lock<std::shared_mutex> lock(mounts_mutex);
+	auto itr = mounts.find(package);
+	if (itr == mounts.end())
+		return "";
+	for (auto& mount : itr->second)
+	{
+		std::string loose_path = mount->get_loose_path(relative);
+		if (!loose_path.empty())
+			return loose_path;
+	}
+	return "";
+}
+
+std::vector<std::pair<std::string, filesystem::file_stats>> filesystem::get_files_stats()
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	return { files_stats.begin(), files_stats.end() };
+}
+
+void filesystem::reset_files_stats()
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	files_stats.clear();
+}
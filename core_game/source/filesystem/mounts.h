@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace filesystem
+{
+	/*
+		file_stats
+		latency counters of a single file, collected by read_file
+	*/
+	struct file_stats
+	{
+		uint32_t opens = 0;
+		uint32_t reads = 0;
+		uint64_t bytes_read = 0;
+		//time spent on finding and opening the file
+		uint64_t open_nanoseconds = 0;
+		//time spent on reading (and decompressing) the file
+		uint64_t read_nanoseconds = 0;
+	};
+
+	/*
+		mount
+		backend providing files of a package
+		all methods have to be thread safe
+	*/
+	class mount
+	{
+	public:
+		virtual ~mount() {};
+		/*
+			exists
+			checks if file exists
+			-l-
+			[path] path relative to the package, eg. "sprites/player.png"
+		*/
+		virtual bool exists(const std::string& path) = 0;
+		/*
+			read
+			reads whole file into data
+			returns false if file doesn't exist
+		*/
+		virtual bool read(const std::string& path, std::string& data, file_stats& stats) = 0;
+		/*
+			get_loose_path
+			returns absolute path of the file on disk, or empty string if file isn't a loose file
+		*/
+		virtual std::string get_loose_path(const std::string& path) { return ""; };
+	};
+
+	/*
+		create_loose_mount
+		creates mount reading files from the given directory
+	*/
+	std::unique_ptr<mount> create_loose_mount(const std::string& directory);
+	/*
+		create_pack_mount
+		creates mount reading files from the given pack file
+		see create_pack for the format
+	*/
+	std::unique_ptr<mount> create_pack_mount(const std::string& pack_path);
+	/*
+		create_pack
+		packs all files in the directory (with subdirectories) into a single pack file
+		packed files are split into chunks, each one compressed independently if compress is true
+		-l-
+		[compress] if true chunks are compressed with lz4
+	*/
+	void create_pack(const std::string& directory, const std::string& pack_path, bool compress);
+
+	/*
+		mount_package
+		adds mount to the package
+		package mounts are searched in the order they were added
+		-l-
+		[package] package name without the slash eg. "mod"
+	*/
+	void mount_package(const std::string& package, std::unique_ptr<mount> mount);
+	/*
+		unmount_package
+		removes all package mounts
+	*/
+	void unmount_package(const std::string& package);
+	/*
+		mount_package_directory
+		mounts directory as the package
+		if directory contains [package].pack file, it is mounted after the directory,
+		so loose files override packed ones
+	*/
+	void mount_package_directory(const std::string& package, const std::string& directory);
+
+	/*
+		read_mounted_file
+		reads file from the first package mount containing it
+		returns false if there is no such file
+		thread safe
+		-l-
+		[path] resolved path eg. "mod/sprites/player.png"
+	*/
+	bool read_mounted_file(const std::string& path, std::string& data);
+	/*
+		mounted_file_exists
+		thread safe
+	*/
+	bool mounted_file_exists(const std::string& path);
+	/*
+		get_mounted_loose_path
+		returns absolute path of the file in the first loose directory mounted for its package,
+		even if the file doesn't exist yet
+		returns empty string if package has no loose directory mounted
+	*/
+	std::string get_mounted_loose_path(const std::string& path);
+
+	/*
+		get_files_stats
+		returns latency counters of all files read since the last reset_files_stats
+	*/
+	std::vector<std::pair<std::string, file_stats>> get_files_stats();
+	void reset_files_stats();
+}
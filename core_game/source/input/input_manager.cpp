@@ -5,6 +5,7 @@
 
 #include "source/common/common.h"
 #include "source/window/window_manager.h"
+#include "source/events/event_bus.h"
 
 #include <string>
 #include <unordered_map>
@@ -80,6 +81,9 @@ void input_manager::update_mappings_states()
 			state.a = action.second.get_value(pressed_keys);
 		else
 			state.b = action.second.get_value(pressed_keys);
+
+		if (state.a != state.b)
+			common::event_bus->emit_input_action(action.first, impl->a_action_state_is_current ? state.a : state.b);
 	}
 
 	for (const auto& axis : impl->config_asset->axis_mappings)
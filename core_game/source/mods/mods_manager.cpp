@@ -2,6 +2,7 @@
 
 #include "include/nlohmann/json.hpp"
 #include "source/filesystem/filesystem.h"
+#include "source/filesystem/mounts.h"
 
 #include "source/common/crash.h"
 
@@ -12,12 +13,18 @@
 #include "source/input/input_manager.h"
 #include "source/audio/audio_manager.h"
 #include "source/rendering/renderer.h"
+#include "source/events/event_bus.h"
 
 #include "source/utilities/hash_string.h"
 
 #include "../../debug_config.h"
 
+#include <chrono>
+
 static std::string current_mod_name = "";
+//assets listed in the manifest preload, kept loaded until the mod is unloaded
+static std::vector<std::string> preloaded_assets;
+static mods::preload_stats last_preload_stats;
 
 void load_mod_implementation(std::string mod_folder);
 
@@ -40,8 +47,17 @@ void mods::mods_manager::load_mod_selection_mod()
 
 void mods::mods_manager::unload_mod()
 {
+	//stats are read with behaviors_manager::get_most_expensive_behaviors while the mod runs
+	common::behaviors_manager->reset_behaviors_stats();
 	common::world = std::make_unique<entities::world>();
+	common::event_bus->clear();
 	common::behaviors_manager->clear();
+	common::assets_manager->stop_watching();
+
+	for (auto& path : preloaded_assets)
+		common::assets_manager->unlock_asset(utilities::hash_string(path));
+	preloaded_assets.clear();
+	last_preload_stats = {};
 
 	current_mod_name = "";
 }
@@ -75,12 +91,65 @@ std::vector<std::string> mods::mods_manager::get_all_mods()
 	return mods;
 }
 
+const mods::preload_stats& mods::mods_manager::get_preload_stats()
+{
+	return last_preload_stats;
+}
+
+void load_lua_config(const nlohmann::json& config)
+{
+	if (!config.is_object())
+		error_handling::crash(error_handling::error_source::core, "[mods_manager::load_mod]",
+			"Invalid mod manifest: lua isn't object");
+
+	auto get_parameter = [&](const char* name) -> int
+	{
+		if (!config.contains(name))
+			return 0;
+		if (!config.at(name).is_number_integer() || config.at(name) < 0)
+			error_handling::crash(error_handling::error_source::core, "[mods_manager::load_mod]",
+				"Invalid mod manifest: lua " + std::string(name) + " isn't non-negative integer");
+		return config.at(name);
+	};
+
+	if (config.contains("memory_limit"))
+	{
+		if (!config.at("memory_limit").is_number() || config.at("memory_limit") < 0)
+			error_handling::crash(error_handling::error_source::core, "[mods_manager::load_mod]",
+				"Invalid mod manifest: lua memory_limit isn't non-negative number");
+		double megabytes = config.at("memory_limit");
+		common::behaviors_manager->set_memory_limit(static_cast<size_t>(megabytes * 1024 * 1024));
+	}
+
+	std::string gc = "incremental";
+	if (config.contains("gc"))
+	{
+		if (!config.at("gc").is_string())
+			error_handling::crash(error_handling::error_source::core, "[mods_manager::load_mod]",
+				"Invalid mod manifest: lua gc isn't string");
+		gc = config.at("gc");
+	}
+
+	if (gc == "incremental")
+		common::behaviors_manager->set_incremental_gc(
+			get_parameter("gc_pause"), get_parameter("gc_step_multiplier"), get_parameter("gc_step_size"));
+	else if (gc == "generational")
+		common::behaviors_manager->set_generational_gc(
+			get_parameter("gc_minor_multiplier"), get_parameter("gc_major_multiplier"));
+	else
+		error_handling::crash(error_handling::error_source::core, "[mods_manager::load_mod]",
+			"Invalid mod manifest: lua gc should be incremental or generational");
+}
+
 void load_mod_implementation(std::string mod_folder)
 {
+	filesystem::reset_files_stats();
 	filesystem::set_mod_assets_directory(mod_folder);
-	auto manifest_file = filesystem::load_file("mod/manifest.json");
-	nlohmann::json manifest = nlohmann::json::parse(manifest_file);
-	manifest_file.close();
+#ifdef _DEBUG
+	//reload modified assets while the mod is running
+	common::assets_manager->watch_directory(mod_folder);
+#endif
+	nlohmann::json manifest = nlohmann::json::parse(filesystem::load_file_data("mod/manifest.json"));
 
 	size_t index = mod_folder.find_last_of('/');
 	current_mod_name = mod_folder.substr(index + 1, mod_folder.size());
@@ -116,6 +185,9 @@ void load_mod_implementation(std::string mod_folder)
 
 	common::audio_manager->set_audio_rolloff(manifest.at("audio_rolloff"));
 
+	if (manifest.contains("lua"))
+		load_lua_config(manifest.at("lua"));
+
 	common::assets_manager->load_asset("mod/collision_config");
 	common::assets_manager->lock_asset(utilities::hash_string("mod/collision_config"));
 
@@ -126,6 +198,28 @@ void load_mod_implementation(std::string mod_folder)
 	common::assets_manager->lock_asset(utilities::hash_string("mod/rendering_config"));
 	common::renderer->load_config();
 
+	if (manifest.contains("preload"))
+	{
+		if (!manifest.at("preload").is_array())
+			error_handling::crash(error_handling::error_source::core, "[mods_manager::load_mod]",
+				"Invalid mod manifest: preload isn't array");
+
+		for (auto& path : manifest.at("preload"))
+		{
+			if (!path.is_string())
+				error_handling::crash(error_handling::error_source::core, "[mods_manager::load_mod]",
+					"Invalid mod manifest: preload should contain asset paths");
+			preloaded_assets.push_back("mod" + path.get<std::string>());
+		}
+
+		auto preload_start = std::chrono::steady_clock::now();
+		common::assets_manager->load_assets(preloaded_assets);
+		for (auto& path : preloaded_assets)
+			common::assets_manager->lock_asset(utilities::hash_string(path));
+		last_preload_stats.assets = preloaded_assets.size();
+		last_preload_stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - preload_start).count();
+	}
+
 	auto input_config = assets::cast_asset<assets::input_config>
 		(common::assets_manager->get_asset(utilities::hash_string("mod/input_config")));
 	common::input_mananger->load_config(input_config.lock());
@@ -4,6 +4,18 @@
 
 namespace mods
 {
+	/*
+		preload_stats
+		cost of loading the assets listed in the manifest preload of the current mod
+		-l-
+		[milliseconds]	time of decoding and uploading all of them
+	*/
+	struct preload_stats
+	{
+		size_t assets = 0;
+		double milliseconds = 0;
+	};
+
 	class mods_manager
 	{
 	public:
@@ -13,5 +25,6 @@ namespace mods
 		std::string get_current_mod_name();
 		std::string get_mods_directory();
 		std::vector<std::string> get_all_mods();
+		const preload_stats& get_preload_stats();
 	};
 }
\ No newline at end of file
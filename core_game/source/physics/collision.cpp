@@ -40,4 +40,13 @@ namespace physics
 			return collision_response::ignore;
 		return collision_response::overlap;
 	}
-}
\ No newline at end of file
+
+	uint16_t get_interacting_body_types(const collision_preset& preset)
+	{
+		uint16_t mask = 0;
+		for (int body_type = 0; body_type < (1 << collision_preset_body_type_size); body_type++)
+			if (get_bit(preset, body_type * 2) || get_bit(preset, body_type * 2 + 1))
+				mask |= uint16_t(1 << body_type);
+		return mask;
+	}
+}
@@ -119,4 +119,20 @@ namespace physics
 		returns how would two colliders interact
 	*/
 	collision_response get_response_type(const collision_preset& f1, const collision_preset& f2);
+
+	/*
+		get_body_type
+		returns body type stored at the begining of the preset
+	*/
+	inline uint8_t get_body_type(const collision_preset& preset)
+	{
+		return uint8_t(preset >> (sizeof(collision_preset) * 8 - collision_preset_body_type_size));
+	}
+
+	/*
+		get_interacting_body_types
+		returns mask with a bit for each body type the preset doesn't ignore
+		colliders of other body types always get ignore response with the preset
+	*/
+	uint16_t get_interacting_body_types(const collision_preset& preset);
 }
\ No newline at end of file
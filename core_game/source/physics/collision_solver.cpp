@@ -1,10 +1,22 @@
 #include "collision_solver.h"
 #include "source/entities/entity.h"
+#include "source/common/common.h"
+#include "dynamics_manager.h"
 
 #include "include/glm/glm.hpp"
 
 #include <vector>
+#include <array>
+#include <unordered_map>
 #include <algorithm>
+#include <cmath>
+#include <thread>
+#include <atomic>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define COLLISION_SOLVER_SSE
+#endif
 
 using collider = entities::components::collider;
 
@@ -12,9 +24,331 @@ namespace physics
 {
 	struct collision_solver::implementation
 	{
-		std::vector<collider*> all_colliders;
+		colliders_pool pool;
+		/*
+			swept_candidates
+			boxes of the sweep candidates in structure of arrays form, tested 4 at a time against the swept box
+			padded to a multiple of 4 with boxes that never overlap
+		*/
+		struct swept_candidates
+		{
+			std::vector<size_t> indices;
+			std::vector<float> min_x, min_y, max_x, max_y;
+
+			void clear();
+			void push(size_t index, glm::vec2 min, glm::vec2 max);
+			void pad();
+		};
+		swept_candidates sweep_boxes;
+		//bodies moving further than their size are moved in up to this many substeps
+		static constexpr int max_substeps = 8;
+
+		//Responses between presets, presets get dense ids when colliders using them are registered
+		static constexpr uint8_t max_presets = 64;
+		static constexpr uint8_t no_preset_id = UINT8_MAX;
+		std::vector<collision_preset> known_presets;
+		std::vector<uint16_t> interacting_types;
+		std::array<collision_response, max_presets * max_presets> responses;
+
+		//Spatial grid, every collider is listed in each cell its box overlaps
+		//cell keeps mask of body types listed in it, so queries skip cells of body types they ignore
+		struct grid_cell
+		{
+			uint16_t body_types = 0;
+			std::vector<collider*> colliders;
+		};
+		//Every layer has separate cells, so sweeps don't see colliders on other layers
+		//colliders covering more than max_collider_cells are kept in oversized instead of the cells, and tested by every query
+		struct layer_partition
+		{
+			int layer;
+			std::unordered_map<uint64_t, grid_cell> cells;
+			std::vector<collider*> oversized;
+		};
+		static constexpr float cell_size = 4.0f;
+		static constexpr uint64_t max_collider_cells = 1024;
+		//cell coordinates are clamped to this, so huge or infinite positions don't overflow
+		static constexpr int max_cell_coord = 1 << 24;
+		std::vector<layer_partition> partitions;
+		//colliders found in cells by the queries, reused between queries
+		std::vector<collider*> found;
+		//stamp of the last gather which found the collider, dedupes colliders listed in many cells without sorting
+		std::vector<uint32_t> gather_marks;
+		uint32_t gather_stamp = 0;
+
+		mutable std::atomic<size_t> candidates{ 0 };
+		mutable std::atomic<size_t> narrowphase_tests{ 0 };
+
+		uint8_t intern_preset(collision_preset preset);
+		uint8_t find_preset_id(collision_preset preset) const;
+		collision_response get_response(collision_preset preset, uint8_t preset_id, size_t other) const;
+		uint16_t get_interacting_types(collision_preset preset, uint8_t preset_id) const;
+
+		static uint64_t cell_key(int x, int y) { return (uint64_t(uint32_t(x)) << 32) | uint32_t(y); }
+		static int cell_coord(float v);
+		static cells_range get_cells(glm::vec2 min, glm::vec2 max);
+		static uint64_t cells_count(const cells_range& cells);
+		static bool cells_overlap(const cells_range& a, const cells_range& b);
+		//conservative size used to list the collider in grid cells
+		static glm::vec2 get_half_size(glm::vec2 extend) { return glm::abs(extend) / 2.0f; }
+		//size the collider collides with, as used by the ray and the sweep tests
+		static glm::vec2 get_collision_half_size(glm::vec2 extend) { return glm::abs(extend) / 4.0f; }
+		layer_partition& get_partition(int layer);
+		//calls func with the cell at (x, y) of the layer, or of every layer for any_layer
+		template<class F>
+		void for_each_cell_at(int x, int y, int layer, F func) const;
+		void insert_to_grid(collider* c, const cells_range& cells, int layer);
+		void remove_from_grid(collider* c, const cells_range& cells, int layer);
+		//gathers unique colliders of given body types from cells into found
+		//ranges with more cells than colliders in the pool scan the pool instead
+		void gather(const cells_range& cells, uint16_t body_types, int layer);
+		bool matches_layer(size_t index, int layer) const { return layer == collision_solver::any_layer || pool.layers[index] == layer; }
+		bool matches_body_types(size_t index, uint16_t body_types) const { return (uint16_t(1 << get_body_type(pool.presets[index])) & body_types) != 0; }
+		bool passes_filter(size_t index, collision_preset filter, uint8_t filter_id);
+		float distance_to_box(size_t index, glm::vec2 point);
+
+		collision_event* check_if_ray_collide(
+			collision_preset trace_preset, uint8_t trace_id, glm::vec2 trace_begin, glm::vec2 trace_dir, size_t index);
+		bool ray_box(
+			glm::vec2 trace_begin, glm::vec2 trace_dir, size_t index, glm::vec2 added_extend, collision_response response, collision_event& e) const;
+		/*
+			trace
+			walks grid cells crossed by the segment and tests colliders listed in them
+			reads only, so it may be called from many threads at once
+			-l-
+			[hits]	when nullptr only the nearest blocking hit is searched for and the walk stops as soon as it is known
+		*/
+		collision_event trace(
+			collision_preset trace_preset, glm::vec2 trace_begin, glm::vec2 trace_end, std::vector<collision_event>* hits, int layer) const;
+		//calls func for each index below count, splitting big counts between worker threads
+		template<class F>
+		static void for_each_parallel(size_t count, F func);
+		bool check_if_collider_collide_on_move(size_t moved, glm::vec2 origin, const glm::vec2& velocity, size_t other, collision_event& e) const;
+		/*
+			sweep_step
+			moves the collider from origin by step against colliders in found, ordered by the time of impact
+			step is slid along every wall it hits
+			-l-
+			[offset]			distance traveled in previous steps, added to distances of the events
+			[collide_event]		set to the first collide, if it is not set yet
+			[overlap_events]	overlaps before the first collide are added, nullptr skips them
+		*/
+		void sweep_step(size_t index, glm::vec2 origin, glm::vec2& step, float offset,
+			collision_event*& collide_event, std::vector<collision_event*>* overlap_events);
+		//calls func with pool index of every sweep candidate overlapping the box
+		template<class F>
+		void for_each_swept_candidate(glm::vec2 min, glm::vec2 max, F func) const;
 	};
 
+	size_t colliders_pool::get_memory_usage() const
+	{
+		return owners.capacity() * sizeof(collider*)
+			+ (positions.capacity() + extends.capacity()) * sizeof(glm::vec2)
+			+ presets.capacity() * sizeof(collision_preset)
+			+ preset_ids.capacity() * sizeof(uint8_t)
+			+ layers.capacity() * sizeof(int)
+			+ cells.capacity() * sizeof(cells_range);
+	}
+
+	int collision_solver::implementation::cell_coord(float v)
+	{
+		float coord = std::floor(v / cell_size);
+		//written so NaN ends at the lower bound
+		if (!(coord > -max_cell_coord))
+			return -max_cell_coord;
+		if (coord > max_cell_coord)
+			return max_cell_coord;
+		return int(coord);
+	}
+
+	cells_range collision_solver::implementation::get_cells(glm::vec2 min, glm::vec2 max)
+	{
+		return { cell_coord(min.x), cell_coord(min.y), cell_coord(max.x), cell_coord(max.y) };
+	}
+
+	uint64_t collision_solver::implementation::cells_count(const cells_range& cells)
+	{
+		if (cells.max_x < cells.min_x || cells.max_y < cells.min_y)
+			return 0;
+		return uint64_t(int64_t(cells.max_x) - cells.min_x + 1) * uint64_t(int64_t(cells.max_y) - cells.min_y + 1);
+	}
+
+	bool collision_solver::implementation::cells_overlap(const cells_range& a, const cells_range& b)
+	{
+		return a.min_x <= b.max_x && a.max_x >= b.min_x && a.min_y <= b.max_y && a.max_y >= b.min_y;
+	}
+
+	uint8_t collision_solver::implementation::intern_preset(collision_preset preset)
+	{
+		uint8_t id = find_preset_id(preset);
+		if (id != no_preset_id || known_presets.size() == max_presets)
+			return id;
+
+		id = uint8_t(known_presets.size());
+		known_presets.push_back(preset);
+		interacting_types.push_back(get_interacting_body_types(preset));
+		for (size_t other = 0; other < known_presets.size(); other++)
+		{
+			responses[id * max_presets + other] = get_response_type(preset, known_presets[other]);
+			responses[other * max_presets + id] = get_response_type(known_presets[other], preset);
+		}
+		return id;
+	}
+
+	uint8_t collision_solver::implementation::find_preset_id(collision_preset preset) const
+	{
+		for (size_t i = 0; i < known_presets.size(); i++)
+			if (known_presets[i] == preset)
+				return uint8_t(i);
+		return no_preset_id;
+	}
+
+	collision_response collision_solver::implementation::get_response(collision_preset preset, uint8_t preset_id, size_t other) const
+	{
+		uint8_t other_id = pool.preset_ids[other];
+		//Presets above the table size are decoded
+		if (preset_id == no_preset_id || other_id == no_preset_id)
+			return get_response_type(preset, pool.presets[other]);
+		return responses[preset_id * max_presets + other_id];
+	}
+
+	uint16_t collision_solver::implementation::get_interacting_types(collision_preset preset, uint8_t preset_id) const
+	{
+		return preset_id == no_preset_id ? get_interacting_body_types(preset) : interacting_types[preset_id];
+	}
+
+	collision_solver::implementation::layer_partition& collision_solver::implementation::get_partition(int layer)
+	{
+		for (auto& partition : partitions)
+			if (partition.layer == layer)
+				return partition;
+		partitions.push_back({ layer, {} });
+		return partitions.back();
+	}
+
+	template<class F>
+	void collision_solver::implementation::for_each_cell_at(int x, int y, int layer, F func) const
+	{
+		uint64_t key = cell_key(x, y);
+		for (auto& partition : partitions)
+		{
+			if (layer != any_layer && partition.layer != layer)
+				continue;
+			auto cell = partition.cells.find(key);
+			if (cell != partition.cells.end())
+				func(cell->second);
+		}
+	}
+
+	void collision_solver::implementation::insert_to_grid(collider* c, const cells_range& cells, int layer)
+	{
+		auto& partition = get_partition(layer);
+		if (cells_count(cells) > max_collider_cells)
+		{
+			partition.oversized.push_back(c);
+			return;
+		}
+		uint16_t body_type = uint16_t(1 << get_body_type(pool.presets[c->pool_index]));
+		for (int x = cells.min_x; x <= cells.max_x; x++)
+			for (int y = cells.min_y; y <= cells.max_y; y++)
+			{
+				auto& cell = partition.cells[cell_key(x, y)];
+				cell.colliders.push_back(c);
+				cell.body_types |= body_type;
+			}
+	}
+
+	void collision_solver::implementation::remove_from_grid(collider* c, const cells_range& cells, int layer)
+	{
+		auto& partition = get_partition(layer);
+		if (cells_count(cells) > max_collider_cells)
+		{
+			auto it = std::find(partition.oversized.begin(), partition.oversized.end(), c);
+			if (it != partition.oversized.end())
+			{
+				*it = partition.oversized.back();
+				partition.oversized.pop_back();
+			}
+			return;
+		}
+		for (int x = cells.min_x; x <= cells.max_x; x++)
+			for (int y = cells.min_y; y <= cells.max_y; y++)
+			{
+				auto cell = partition.cells.find(cell_key(x, y));
+				if (cell == partition.cells.end())
+					continue;
+				auto& list = cell->second.colliders;
+				auto it = std::find(list.begin(), list.end(), c);
+				if (it != list.end())
+				{
+					*it = list.back();
+					list.pop_back();
+				}
+				if (list.empty())
+				{
+					partition.cells.erase(cell);
+					continue;
+				}
+				uint16_t body_types = 0;
+				for (auto other : list)
+					body_types |= uint16_t(1 << get_body_type(pool.presets[other->pool_index]));
+				cell->second.body_types = body_types;
+			}
+	}
+
+	void collision_solver::implementation::gather(const cells_range& cells, uint16_t body_types, int layer)
+	{
+		found.clear();
+		if (gather_marks.size() < pool.size())
+			gather_marks.resize(pool.size(), 0);
+		if (++gather_stamp == 0)
+		{
+			std::fill(gather_marks.begin(), gather_marks.end(), 0);
+			gather_stamp = 1;
+		}
+
+		if (cells_count(cells) > pool.size())
+		{
+			for (size_t i = 0; i < pool.size(); i++)
+				if (matches_layer(i, layer) && matches_body_types(i, body_types) && cells_overlap(pool.cells[i], cells))
+					found.push_back(pool.owners[i]);
+			candidates.fetch_add(found.size(), std::memory_order_relaxed);
+			return;
+		}
+
+		for (int x = cells.min_x; x <= cells.max_x; x++)
+			for (int y = cells.min_y; y <= cells.max_y; y++)
+				for_each_cell_at(x, y, layer, [&](const grid_cell& cell)
+					{
+						if (!(cell.body_types & body_types))
+							return;
+						for (auto c : cell.colliders)
+							if (gather_marks[c->pool_index] != gather_stamp)
+							{
+								gather_marks[c->pool_index] = gather_stamp;
+								found.push_back(c);
+							}
+					});
+		for (auto& partition : partitions)
+			if (layer == collision_solver::any_layer || partition.layer == layer)
+				for (auto c : partition.oversized)
+					if (matches_body_types(c->pool_index, body_types) && cells_overlap(pool.cells[c->pool_index], cells))
+						found.push_back(c);
+		candidates.fetch_add(found.size(), std::memory_order_relaxed);
+	}
+
+	bool collision_solver::implementation::passes_filter(size_t index, collision_preset filter, uint8_t filter_id)
+	{
+		return filter == 0 || get_response(filter, filter_id, index) != collision_response::ignore;
+	}
+
+	float collision_solver::implementation::distance_to_box(size_t index, glm::vec2 point)
+	{
+		glm::vec2 half = get_collision_half_size(pool.extends[index]);
+		glm::vec2 offset = glm::max(glm::abs(point - pool.positions[index]) - half, glm::vec2(0, 0));
+		return glm::length(offset);
+	}
+
 	collision_solver::collision_solver() :
 		impl(new implementation) {};
 
@@ -25,22 +359,234 @@ namespace physics
 
 	void collision_solver::register_collider(collider* c)
 	{
-		impl->all_colliders.push_back(c);
+		auto& pool = impl->pool;
+		c->pool_index = pool.size();
+		pool.owners.push_back(c);
+		pool.positions.push_back(c->get_world_pos());
+		pool.extends.push_back(c->extend);
+		pool.presets.push_back(c->preset);
+		pool.preset_ids.push_back(impl->intern_preset(c->preset));
+		pool.layers.push_back(c->get_layer());
+
+		glm::vec2 half = implementation::get_half_size(c->extend);
+		cells_range cells = implementation::get_cells(c->get_world_pos() - half, c->get_world_pos() + half);
+		pool.cells.push_back(cells);
+		impl->insert_to_grid(c, cells, pool.layers.back());
+	}
+
+	void collision_solver::reserve(size_t additional)
+	{
+		auto& pool = impl->pool;
+		size_t capacity = pool.size() + additional;
+		pool.owners.reserve(capacity);
+		pool.positions.reserve(capacity);
+		pool.extends.reserve(capacity);
+		pool.presets.reserve(capacity);
+		pool.preset_ids.reserve(capacity);
+		pool.layers.reserve(capacity);
+		pool.cells.reserve(capacity);
 	}
 
 	void collision_solver::unregister_collider(entities::components::collider* c)
 	{
-#define target impl->all_colliders
-		target.erase(std::remove(target.begin(), target.end(), c), target.end());
-#undef target
+		auto& pool = impl->pool;
+		size_t index = c->pool_index;
+		size_t last = pool.size() - 1;
+		impl->remove_from_grid(c, pool.cells[index], pool.layers[index]);
+		if (index != last)
+		{
+			pool.owners[index] = pool.owners[last];
+			pool.positions[index] = pool.positions[last];
+			pool.extends[index] = pool.extends[last];
+			pool.presets[index] = pool.presets[last];
+			pool.preset_ids[index] = pool.preset_ids[last];
+			pool.layers[index] = pool.layers[last];
+			pool.cells[index] = pool.cells[last];
+			pool.owners[index]->pool_index = index;
+		}
+		pool.owners.pop_back();
+		pool.positions.pop_back();
+		pool.extends.pop_back();
+		pool.presets.pop_back();
+		pool.preset_ids.pop_back();
+		pool.layers.pop_back();
+		pool.cells.pop_back();
+		c->pool_index = collider::npos;
+	}
+
+	void collision_solver::update_collider(entities::components::collider* c)
+	{
+		auto& pool = impl->pool;
+		size_t index = c->pool_index;
+		glm::vec2 old_position = pool.positions[index];
+		pool.positions[index] = c->get_world_pos();
+		pool.extends[index] = c->extend;
+
+		//Bodies resting on or blocked by the collider may be free to move now
+		if (old_position != pool.positions[index])
+		{
+			glm::vec2 reach = implementation::get_collision_half_size(c->extend) + glm::vec2(0.1f, 0.1f);
+			common::dynamics_manager->wake_in_box(old_position - reach, old_position + reach);
+			common::dynamics_manager->wake_in_box(pool.positions[index] - reach, pool.positions[index] + reach);
+		}
+
+		bool preset_changed = pool.presets[index] != c->preset;
+		if (preset_changed)
+		{
+			pool.presets[index] = c->preset;
+			pool.preset_ids[index] = impl->intern_preset(c->preset);
+		}
+		int old_layer = pool.layers[index];
+		pool.layers[index] = c->get_layer();
+
+		//Grid is touched only when the collider crosses a cell border, changes its body type or moves to other layer
+		glm::vec2 half = implementation::get_half_size(c->extend);
+		cells_range cells = implementation::get_cells(pool.positions[index] - half, pool.positions[index] + half);
+		if (cells != pool.cells[index] || preset_changed || old_layer != pool.layers[index])
+		{
+			impl->remove_from_grid(c, pool.cells[index], old_layer);
+			impl->insert_to_grid(c, cells, pool.layers[index]);
+			pool.cells[index] = cells;
+		}
+	}
+
+	void collision_solver::query_box(glm::vec2 min, glm::vec2 max, collision_preset filter, std::vector<collider*>& result, int layer)
+	{
+		auto& pool = impl->pool;
+		result.clear();
+		uint8_t filter_id = impl->find_preset_id(filter);
+		impl->gather(implementation::get_cells(min, max), filter == 0 ? UINT16_MAX : impl->get_interacting_types(filter, filter_id), layer);
+		for (auto c : impl->found)
+		{
+			size_t i = c->pool_index;
+			if (!impl->passes_filter(i, filter, filter_id))
+				continue;
+			glm::vec2 half = implementation::get_collision_half_size(pool.extends[i]);
+			glm::vec2 position = pool.positions[i];
+			if (position.x + half.x >= min.x && position.x - half.x <= max.x &&
+				position.y + half.y >= min.y && position.y - half.y <= max.y)
+				result.push_back(c);
+		}
+	}
+
+	void collision_solver::query_circle(glm::vec2 center, float radius, collision_preset filter, std::vector<collider*>& result, int layer)
+	{
+		result.clear();
+		glm::vec2 reach = { radius, radius };
+		uint8_t filter_id = impl->find_preset_id(filter);
+		impl->gather(implementation::get_cells(center - reach, center + reach), filter == 0 ? UINT16_MAX : impl->get_interacting_types(filter, filter_id), layer);
+		for (auto c : impl->found)
+		{
+			size_t i = c->pool_index;
+			if (impl->passes_filter(i, filter, filter_id) && impl->distance_to_box(i, center) <= radius)
+				result.push_back(c);
+		}
+	}
+
+	collider* collision_solver::nearest(glm::vec2 point, float max_distance, collision_preset filter, float& distance, int layer)
+	{
+		auto& pool = impl->pool;
+		collider* best = nullptr;
+		distance = max_distance;
+		if (!(max_distance >= 0))
+			return nullptr;
+		uint8_t filter_id = impl->find_preset_id(filter);
+		uint16_t body_types = filter == 0 ? UINT16_MAX : impl->get_interacting_types(filter, filter_id);
+
+		auto test = [&](collider* c)
+		{
+			size_t i = c->pool_index;
+			if (!impl->passes_filter(i, filter, filter_id))
+				return;
+			float d = impl->distance_to_box(i, point);
+			if (d <= distance && (best == nullptr || d < distance))
+			{
+				best = c;
+				distance = d;
+			}
+		};
+
+		//Walking the rings would visit more cells than there are colliders, so the pool is scanned instead
+		//this also covers infinite max_distance and points outside the clamped cell coordinates
+		float rings = std::ceil(max_distance / implementation::cell_size);
+		float grid_reach = implementation::max_cell_coord * implementation::cell_size;
+		if (!(rings * 2 + 1 <= float(implementation::max_cell_coord)) || (uint64_t(rings) * 2 + 1) * (uint64_t(rings) * 2 + 1) > pool.size()
+			|| !(std::abs(point.x) < grid_reach && std::abs(point.y) < grid_reach))
+		{
+			for (size_t i = 0; i < pool.size(); i++)
+				if (impl->matches_layer(i, layer) && impl->matches_body_types(i, body_types))
+					test(pool.owners[i]);
+			return best;
+		}
+
+		for (auto& partition : impl->partitions)
+			if (layer == any_layer || partition.layer == layer)
+				for (auto c : partition.oversized)
+					if (impl->matches_body_types(c->pool_index, body_types))
+						test(c);
+
+		auto visit = [&](int x, int y)
+		{
+			impl->for_each_cell_at(x, y, layer, [&](const implementation::grid_cell& cell)
+				{
+					if (!(cell.body_types & body_types))
+						return;
+					for (auto c : cell.colliders)
+						test(c);
+				});
+		};
+
+		//Rings of cells around the point, only cells on the border of each ring are visited
+		//stops once the ring is further than the best hit
+		int center_x = implementation::cell_coord(point.x);
+		int center_y = implementation::cell_coord(point.y);
+		int max_ring = int(rings);
+		visit(center_x, center_y);
+		for (int ring = 1; ring <= max_ring; ring++)
+		{
+			if (best != nullptr && (ring - 1) * implementation::cell_size > distance)
+				break;
+
+			for (int x = center_x - ring; x <= center_x + ring; x++)
+			{
+				visit(x, center_y - ring);
+				visit(x, center_y + ring);
+			}
+			for (int y = center_y - ring + 1; y <= center_y + ring - 1; y++)
+			{
+				visit(center_x - ring, y);
+				visit(center_x + ring, y);
+			}
+		}
+		return best;
+	}
+
+	const colliders_pool& collision_solver::get_pool()
+	{
+		return impl->pool;
+	}
+
+	collision_stats collision_solver::get_stats()
+	{
+		collision_stats stats;
+		stats.candidates = impl->candidates.load();
+		stats.narrowphase_tests = impl->narrowphase_tests.load();
+		return stats;
+	}
+
+	void collision_solver::reset_stats()
+	{
+		impl->candidates = 0;
+		impl->narrowphase_tests = 0;
 	}
 
 	collision_event* collision_solver::check_if_ray_collide(
 		collision_preset trace_preset, glm::vec2 trace_begin, glm::vec2 trace_dir)
 	{
-		for (auto& c : impl->all_colliders)
+		uint8_t trace_id = impl->find_preset_id(trace_preset);
+		for (size_t i = 0; i < impl->pool.size(); i++)
 		{
-			auto event = check_if_ray_collide(trace_preset, trace_begin, trace_dir, c);
+			auto event = impl->check_if_ray_collide(trace_preset, trace_id, trace_begin, trace_dir, i);
 
 			if (event == nullptr)
 				continue;
@@ -57,125 +603,443 @@ namespace physics
 	collision_event* collision_solver::check_if_ray_collide(
 		collision_preset trace_preset, glm::vec2 trace_begin, glm::vec2 trace_dir, entities::components::collider* collider)
 	{
-		glm::vec2 near = (collider->get_world_pos() - (glm::vec2{collider->extend.x, -collider->extend.y} / 4.0f) - trace_begin) / trace_dir;
-		glm::vec2 far = (collider->get_world_pos() + (glm::vec2{collider->extend.x, -collider->extend.y} / 4.0f) - trace_begin) / trace_dir;
+		if (collider->pool_index == entities::components::collider::npos)
+			return nullptr;
+		return impl->check_if_ray_collide(trace_preset, impl->find_preset_id(trace_preset), trace_begin, trace_dir, collider->pool_index);
+	}
+
+	collision_event* collision_solver::implementation::check_if_ray_collide(
+		collision_preset trace_preset, uint8_t trace_id, glm::vec2 trace_begin, glm::vec2 trace_dir, size_t index)
+	{
+		collision_event e;
+		if (!ray_box(trace_begin, trace_dir, index, { 0, 0 }, get_response(trace_preset, trace_id, index), e))
+			return nullptr;
+		return new collision_event(e);
+	}
+
+	bool collision_solver::implementation::ray_box(
+		glm::vec2 trace_begin, glm::vec2 trace_dir, size_t index, glm::vec2 added_extend, collision_response response, collision_event& e) const
+	{
+		glm::vec2 position = pool.positions[index];
+		glm::vec2 extend = pool.extends[index] + added_extend;
+
+		glm::vec2 near = (position - (glm::vec2{extend.x, -extend.y} / 4.0f) - trace_begin) / trace_dir;
+		glm::vec2 far = (position + (glm::vec2{extend.x, -extend.y} / 4.0f) - trace_begin) / trace_dir;
 
 		if (near.x > far.x) std::swap(near.x, far.x);
 		if (near.y > far.y) std::swap(near.y, far.y);
 
-		if (near.x > far.y || near.y > far.x) return nullptr;
+		if (near.x > far.y || near.y > far.x) return false;
 
 		float hit_near = std::max(near.x, near.y);
 		float hit_far = std::min(far.x, far.y);
 
-		if (hit_far < 0) return nullptr;
+		if (hit_far < 0) return false;
 		if (hit_near != hit_near) hit_near = hit_far;
 
-		collision_event* e = new collision_event;
-
-		e->location = trace_begin + hit_near * trace_dir;
-		e->distance = glm::distance(trace_begin, e->location);
+		e.location = trace_begin + hit_near * trace_dir;
+		e.distance = glm::distance(trace_begin, e.location);
 
+		//Corner hits and rays starting inside the box have no normal, e may hold one of a previous hit
+		e.normal = { 0, 0 };
 		if (near.x > near.y)
 			if (trace_dir.x < 0)
-				e->normal = { 1, 0 };
+				e.normal = { 1, 0 };
 			else
-				e->normal = { -1, 0 };
+				e.normal = { -1, 0 };
 		else if (near.x < near.y)
 			if (trace_dir.y < 0)
-				e->normal = { 0, 1 };
+				e.normal = { 0, 1 };
 			else
-				e->normal = { 0, -1 };
+				e.normal = { 0, -1 };
+
+		e.other = pool.owners[index];
+		e.response = response;
+
+		return true;
+	}
+
+	collision_event collision_solver::implementation::trace(
+		collision_preset trace_preset, glm::vec2 trace_begin, glm::vec2 trace_end, std::vector<collision_event>* hits, int layer) const
+	{
+		collision_event nearest;
+		glm::vec2 dir = trace_end - trace_begin;
+		float length = glm::length(dir);
+		//written so NaN and infinite segments are rejected too
+		if (!(length > 0 && length <= FLT_MAX))
+			return nearest;
+
+		//Grid walk, t is the fraction of the segment where the walk leaves the cell on given axis
+		int x = cell_coord(trace_begin.x);
+		int y = cell_coord(trace_begin.y);
+		int step_x = dir.x > 0 ? 1 : -1;
+		int step_y = dir.y > 0 ? 1 : -1;
+		float t_max_x = dir.x != 0 ? ((x + (step_x > 0)) * cell_size - trace_begin.x) / dir.x : FLT_MAX;
+		float t_max_y = dir.y != 0 ? ((y + (step_y > 0)) * cell_size - trace_begin.y) / dir.y : FLT_MAX;
+		float t_delta_x = dir.x != 0 ? cell_size / std::abs(dir.x) : FLT_MAX;
+		float t_delta_y = dir.y != 0 ? cell_size / std::abs(dir.y) : FLT_MAX;
+
+		uint8_t trace_id = find_preset_id(trace_preset);
+		uint16_t body_types = get_interacting_types(trace_preset, trace_id);
+		//Counted locally, trace may run on many threads
+		size_t cell_candidates = 0;
+		size_t tests = 0;
+
+		collision_event e;
+		auto test = [&](collider* c)
+		{
+			cell_candidates++;
+			auto response = get_response(trace_preset, trace_id, c->pool_index);
+			if (response == collision_response::ignore)
+				return;
+			tests++;
+			if (!ray_box(trace_begin, dir, c->pool_index, { 0, 0 }, response, e) || e.distance > length)
+				return;
+			if (hits != nullptr)
+				hits->push_back(e);
+			else if (e.response == collision_response::collide && e.distance < nearest.distance)
+				nearest = e;
+		};
+
+		//Segment crossing more cells than there are colliders, or leaving the clamped cell coordinates,
+		//tests the pool instead of walking the grid
+		float grid_reach = max_cell_coord * cell_size;
+		glm::vec2 far_corner = glm::max(glm::abs(trace_begin), glm::abs(trace_end));
+		if ((std::abs(dir.x) + std::abs(dir.y)) / cell_size + 2 > float(pool.size()) || far_corner.x >= grid_reach || far_corner.y >= grid_reach)
+		{
+			for (size_t i = 0; i < pool.size(); i++)
+				if (matches_layer(i, layer) && matches_body_types(i, body_types))
+					test(pool.owners[i]);
+		}
+		else
+		{
+			for (auto& partition : partitions)
+				if (layer == collision_solver::any_layer || partition.layer == layer)
+					for (auto c : partition.oversized)
+						if (matches_body_types(c->pool_index, body_types))
+							test(c);
+
+			while (true)
+			{
+				for_each_cell_at(x, y, layer, [&](const grid_cell& cell)
+					{
+						if (!(cell.body_types & body_types))
+							return;
+						for (auto c : cell.colliders)
+							test(c);
+					});
+
+				float t_exit = std::min(t_max_x, t_max_y);
+				if (t_exit > 1.0f || hits == nullptr && nearest.distance <= t_exit * length)
+					break;
+
+				if (t_max_x < t_max_y)
+				{
+					x += step_x;
+					t_max_x += t_delta_x;
+				}
+				else
+				{
+					y += step_y;
+					t_max_y += t_delta_y;
+				}
+			}
+		}
+
+		candidates.fetch_add(cell_candidates, std::memory_order_relaxed);
+		narrowphase_tests.fetch_add(tests, std::memory_order_relaxed);
+
+		if (hits != nullptr)
+		{
+			//Colliders spanning several cells were tested in each of them
+			std::sort(hits->begin(), hits->end(), [](const collision_event& a, const collision_event& b)
+				{
+					return a.other < b.other || a.other == b.other && a.distance < b.distance;
+				});
+			hits->erase(std::unique(hits->begin(), hits->end(), [](const collision_event& a, const collision_event& b)
+				{
+					return a.other == b.other;
+				}), hits->end());
+			std::sort(hits->begin(), hits->end(), [](const collision_event& a, const collision_event& b)
+				{
+					return a.distance < b.distance;
+				});
+		}
+
+		return nearest;
+	}
+
+	template<class F>
+	void collision_solver::implementation::for_each_parallel(size_t count, F func)
+	{
+		const size_t chunk = 64;
+		size_t workers_count = std::thread::hardware_concurrency();
+		if (workers_count > count / chunk)
+			workers_count = count / chunk;
+
+		if (workers_count <= 1)
+		{
+			for (size_t i = 0; i < count; i++)
+				func(i);
+			return;
+		}
+
+		std::atomic<size_t> next = 0;
+		auto work = [&]()
+		{
+			for (size_t begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk))
+				for (size_t i = begin; i < std::min(begin + chunk, count); i++)
+					func(i);
+		};
+
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < workers_count; i++)
+			workers.emplace_back(work);
+		work();
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	collision_event collision_solver::trace_nearest(collision_preset trace_preset, glm::vec2 trace_begin, glm::vec2 trace_end, int layer)
+	{
+		return impl->trace(trace_preset, trace_begin, trace_end, nullptr, layer);
+	}
 
-		e->other = collider;
-		e->response = get_response_type(trace_preset, collider->preset);
+	void collision_solver::trace_all(
+		collision_preset trace_preset, glm::vec2 trace_begin, glm::vec2 trace_end, std::vector<collision_event>& hits, int layer)
+	{
+		hits.clear();
+		impl->trace(trace_preset, trace_begin, trace_end, &hits, layer);
+	}
+
+	void collision_solver::trace_batch(
+		collision_preset trace_preset, const std::vector<glm::vec2>& segments, std::vector<collision_event>& nearest, int layer)
+	{
+		nearest.resize(segments.size() / 2);
+		implementation* solver = impl;
+		implementation::for_each_parallel(nearest.size(), [&](size_t i)
+			{
+				nearest[i] = solver->trace(trace_preset, segments[i * 2], segments[i * 2 + 1], nullptr, layer);
+			});
+	}
 
-		return e;
+	void collision_solver::trace_batch(
+		collision_preset trace_preset, const std::vector<glm::vec2>& segments, std::vector<std::vector<collision_event>>& hits, int layer)
+	{
+		hits.resize(segments.size() / 2);
+		implementation* solver = impl;
+		implementation::for_each_parallel(hits.size(), [&](size_t i)
+			{
+				hits[i].clear();
+				solver->trace(trace_preset, segments[i * 2], segments[i * 2 + 1], &hits[i], layer);
+			});
 	}
 
 	collision_event* collision_solver::check_if_collider_collide_on_move(
 		entities::components::collider* moved_collider, const glm::vec2& velocity, entities::components::collider* other)
 	{
-		auto response = get_response_type(moved_collider->preset, other->preset);
+		if (moved_collider->pool_index == collider::npos || other->pool_index == collider::npos)
+			return nullptr;
+		collision_event e;
+		size_t moved = moved_collider->pool_index;
+		if (!impl->check_if_collider_collide_on_move(moved, impl->pool.positions[moved], velocity, other->pool_index, e))
+			return nullptr;
+		return new collision_event(e);
+	}
+
+	bool collision_solver::implementation::check_if_collider_collide_on_move(
+		size_t moved, glm::vec2 origin, const glm::vec2& velocity, size_t other, collision_event& e) const
+	{
+		auto response = get_response(pool.presets[moved], pool.preset_ids[moved], other);
 
 		if (
 			response == collision_response::ignore ||
-			moved_collider->get_layer() != other->get_layer() ||
-			velocity.x == 0 && velocity.y == 0		
+			pool.layers[moved] != pool.layers[other] ||
+			velocity.x == 0 && velocity.y == 0
 		)
-			return nullptr;
+			return false;
 
-		other->extend += moved_collider->extend;
-		auto e = check_if_ray_collide(moved_collider->preset, moved_collider->get_world_pos(), velocity, other);
-		other->extend -= moved_collider->extend;
+		narrowphase_tests.fetch_add(1, std::memory_order_relaxed);
+		return ray_box(origin, velocity, other, pool.extends[moved], response, e) && e.distance < glm::length(velocity);
+	}
 
-		if (e == nullptr)
-			return nullptr;
-		else if (e->distance < glm::length(velocity))
-			return e;
-		delete e;
-		return nullptr;
+	void collision_solver::implementation::swept_candidates::clear()
+	{
+		indices.clear();
+		min_x.clear();
+		min_y.clear();
+		max_x.clear();
+		max_y.clear();
 	}
 
-	sweep_move_event* collision_solver::sweep_move(
-		entities::components::collider* col, const glm::vec2& end_point)
+	void collision_solver::implementation::swept_candidates::push(size_t index, glm::vec2 min, glm::vec2 max)
 	{
-		glm::vec2 velocity = end_point - col->get_world_pos();
+		indices.push_back(index);
+		min_x.push_back(min.x);
+		min_y.push_back(min.y);
+		max_x.push_back(max.x);
+		max_y.push_back(max.y);
+	}
 
-		if (col->preset == 0 || velocity.x == 0 && velocity.y == 0)
-			return nullptr;
+	void collision_solver::implementation::swept_candidates::pad()
+	{
+		while (min_x.size() % 4 != 0)
+		{
+			min_x.push_back(FLT_MAX);
+			min_y.push_back(FLT_MAX);
+			max_x.push_back(-FLT_MAX);
+			max_y.push_back(-FLT_MAX);
+		}
+	}
 
-		collision_event* collide_event = nullptr;
-		std::vector<collision_event*> overlap_events;
+	template<class F>
+	void collision_solver::implementation::for_each_swept_candidate(glm::vec2 min, glm::vec2 max, F func) const
+	{
+		auto& boxes = sweep_boxes;
+		size_t count = boxes.min_x.size();
+	#ifdef COLLISION_SOLVER_SSE
+		__m128 swept_min_x = _mm_set1_ps(min.x);
+		__m128 swept_min_y = _mm_set1_ps(min.y);
+		__m128 swept_max_x = _mm_set1_ps(max.x);
+		__m128 swept_max_y = _mm_set1_ps(max.y);
+		for (size_t i = 0; i < count; i += 4)
+		{
+			__m128 overlap_x = _mm_and_ps(
+				_mm_cmple_ps(_mm_loadu_ps(&boxes.min_x[i]), swept_max_x),
+				_mm_cmpge_ps(_mm_loadu_ps(&boxes.max_x[i]), swept_min_x));
+			__m128 overlap_y = _mm_and_ps(
+				_mm_cmple_ps(_mm_loadu_ps(&boxes.min_y[i]), swept_max_y),
+				_mm_cmpge_ps(_mm_loadu_ps(&boxes.max_y[i]), swept_min_y));
+			int mask = _mm_movemask_ps(_mm_and_ps(overlap_x, overlap_y));
+			for (int lane = 0; mask != 0; lane++, mask >>= 1)
+				if (mask & 1)
+					func(boxes.indices[i + lane]);
+		}
+	#else
+		for (size_t i = 0; i < count; i++)
+			if (boxes.min_x[i] <= max.x && boxes.max_x[i] >= min.x && boxes.min_y[i] <= max.y && boxes.max_y[i] >= min.y)
+				func(boxes.indices[i]);
+	#endif
+	}
 
-		std::vector<collider*> potential_collisions;
+	void collision_solver::implementation::sweep_step(size_t index, glm::vec2 origin, glm::vec2& step, float offset,
+		collision_event*& collide_event, std::vector<collision_event*>* overlap_events)
+	{
+		//Boxes are tested at the size used by the ray test, slightly grown so the filter never rejects a hit
+		glm::vec2 half = glm::abs(pool.extends[index]) / 4.0f + glm::vec2(0.01f, 0.01f);
+		size_t overlaps_begin = overlap_events != nullptr ? overlap_events->size() : 0;
+		float first_collide = FLT_MAX;
+		collision_event e;
 
-		for (auto& c : impl->all_colliders)
-			if (glm::distance(c->get_world_pos(), col->get_world_pos()) - glm::length(c->extend + col->extend) / 2.0f <= glm::length(velocity))
-				potential_collisions.push_back(c);
+		//Earliest collide is kept as running minimum, step slides once per axis at most
+		for (int pass = 0; pass < 2 && (step.x != 0 || step.y != 0); pass++)
+		{
+			collision_event earliest;
+			glm::vec2 end = origin + step;
+			for_each_swept_candidate(glm::min(origin, end) - half, glm::max(origin, end) + half, [&](size_t other)
+				{
+					if (!check_if_collider_collide_on_move(index, origin, step, other, e))
+						return;
+					if (e.response == collision_response::collide)
+					{
+						if (e.distance < earliest.distance)
+							earliest = e;
+					}
+					else if (pass == 0 && overlap_events != nullptr)
+					{
+						overlap_events->push_back(new collision_event(e));
+						overlap_events->back()->distance += offset;
+					}
+				});
 
-		std::sort(potential_collisions.begin(), potential_collisions.end(), [&](
-			entities::components::collider* a, 
-			entities::components::collider* b)
+			if (earliest.response != collision_response::collide)
+				break;
+			if (pass == 0)
+				first_collide = earliest.distance + offset;
+			step *= (glm::vec2(1, 1) - glm::vec2(std::abs(earliest.normal.x), std::abs(earliest.normal.y)));
+			if (collide_event == nullptr)
 			{
-				return
-					glm::length(a->get_world_pos() - col->get_world_pos()) <
-					glm::length(b->get_world_pos() - col->get_world_pos());
-			});
+				collide_event = new collision_event(earliest);
+				collide_event->distance += offset;
+			}
+		}
 
-		for (auto& c : potential_collisions)
+		//Overlaps behind the first collide don't happen
+		if (overlap_events != nullptr)
 		{
-			if (c == col) continue;
+			auto behind = std::remove_if(overlap_events->begin() + overlaps_begin, overlap_events->end(), [first_collide](collision_event* overlap)
+				{
+					if (overlap->distance < first_collide)
+						return false;
+					delete overlap;
+					return true;
+				});
+			overlap_events->erase(behind, overlap_events->end());
+		}
+	}
 
-			if (glm::distance(c->get_world_pos(), col->get_world_pos()) > glm::length(c->extend + col->extend))
-				continue;
+	sweep_move_event* collision_solver::sweep_move(
+		entities::components::collider* col, const glm::vec2& end_point)
+	{
+		auto& pool = impl->pool;
+		size_t index = col->pool_index;
+		if (index == collider::npos)
+			return nullptr;
 
-			collision_event* e = check_if_collider_collide_on_move(col, velocity, c);
-			if (e == nullptr)
+		glm::vec2 position = pool.positions[index];
+		glm::vec2 velocity = end_point - position;
+
+		if (pool.presets[index] == 0 || velocity.x == 0 && velocity.y == 0)
+			return nullptr;
+
+		//Broadphase, colliders listed in the grid cells covered by the swept box, on the collider's layer
+		glm::vec2 half = implementation::get_half_size(pool.extends[index]);
+		impl->gather(implementation::get_cells(glm::min(position, end_point) - half, glm::max(position, end_point) + half),
+			impl->get_interacting_types(pool.presets[index], pool.preset_ids[index]), pool.layers[index]);
+
+		//Candidates which don't ignore the collider are copied once, and filtered against the swept box of every substep
+		auto& boxes = impl->sweep_boxes;
+		boxes.clear();
+		for (auto c : impl->found)
+		{
+			size_t other = c->pool_index;
+			if (other == index || impl->get_response(pool.presets[index], pool.preset_ids[index], other) == collision_response::ignore)
 				continue;
-			else if (e->response == collision_response::collide)
-			{
-				velocity *= (glm::vec2(1, 1) - glm::vec2(std::abs(e->normal.x), std::abs(e->normal.y)));
-				if (collide_event == nullptr || e->distance < collide_event->distance)
-					collide_event = e;
-				else
-					delete e;
-			}
-			else if (e->response == collision_response::overlap)
-				overlap_events.push_back(std::move(e));
+			glm::vec2 other_half = glm::abs(pool.extends[other]) / 4.0f;
+			boxes.push(other, pool.positions[other] - other_half, pool.positions[other] + other_half);
 		}
+		boxes.pad();
 
-		sweep_move_event* sme = new sweep_move_event;
-		sme->velocity = std::move(velocity);
-		sme->collide_event = std::move(collide_event);
+		//Body moving further than its size is moved in substeps, so it slides along every wall on its path
+		glm::vec2 size = glm::max(half, glm::vec2(0.01f, 0.01f));
+		float steps_needed = std::ceil(std::max(std::abs(velocity.x) / size.x, std::abs(velocity.y) / size.y));
+		int substeps = static_cast<int>(std::min(std::max(steps_needed, 1.0f), float(implementation::max_substeps)));
 
-		if (sme->collide_event == nullptr)
-			sme->overlap_events = std::move(overlap_events);
-		else
-			for (auto& event : overlap_events)
-				if (event->distance < sme->collide_event->distance)
-					sme->overlap_events.push_back(std::move(event));
+		collision_event* collide_event = nullptr;
+		std::vector<collision_event*> overlap_events;
+		glm::vec2 origin = position;
+		glm::vec2 moved = { 0, 0 };
+		float traveled = 0;
+		//Components stopped by a wall stay stopped in the next substeps
+		glm::vec2 free_axes = { 1, 1 };
+
+		for (int i = 0; i < substeps; i++)
+		{
+			glm::vec2 planned = velocity / float(substeps) * free_axes;
+			glm::vec2 step = planned;
+			impl->sweep_step(index, origin, step, traveled, collide_event, collide_event == nullptr ? &overlap_events : nullptr);
+			if (planned.x != 0 && step.x == 0) free_axes.x = 0;
+			if (planned.y != 0 && step.y == 0) free_axes.y = 0;
+			origin += step;
+			moved += step;
+			traveled += glm::length(step);
+		}
+
+		sweep_move_event* sme = new sweep_move_event;
+		sme->velocity = moved;
+		sme->collide_event = collide_event;
+		sme->overlap_events = std::move(overlap_events);
 
 		return sme;
 	}
-}
\ No newline at end of file
+}
@@ -3,13 +3,68 @@
 #include "collision.h"
 #include "include/glm/vec2.hpp"
 
+#include <vector>
+#include <climits>
+
 namespace physics
 {
+	/*
+		cells_range
+		cells of the spatial grid overlapped by the collider, inclusive
+	*/
+	struct cells_range
+	{
+		int min_x, min_y, max_x, max_y;
+		bool operator==(const cells_range& o) const { return min_x == o.min_x && min_y == o.min_y && max_x == o.max_x && max_y == o.max_y; }
+		bool operator!=(const cells_range& o) const { return !(*this == o); }
+	};
+
+	/*
+		collision_stats
+		work done by the broadphase and the narrowphase since the last reset
+		-l-
+		[candidates]			colliders read from the grid cells by sweeps and traces
+		[narrowphase_tests]		candidates which didn't ignore each other and were tested for the hit
+	*/
+	struct collision_stats
+	{
+		size_t candidates = 0;
+		size_t narrowphase_tests = 0;
+	};
+
+	/*
+		colliders_pool
+		state of registered colliders in structure of arrays form, read by the broadphase
+		collider keeps its index in the pool
+	*/
+	struct colliders_pool
+	{
+		std::vector<entities::components::collider*> owners;
+		//world space locations
+		std::vector<glm::vec2> positions;
+		std::vector<glm::vec2> extends;
+		std::vector<collision_preset> presets;
+		//dense ids of the presets in the solver's response table
+		std::vector<uint8_t> preset_ids;
+		std::vector<int> layers;
+		//cells of the spatial grid containing the collider
+		std::vector<cells_range> cells;
+
+		size_t size() const { return owners.size(); }
+		/*
+			get_memory_usage
+			returns bytes reserved by the pool
+		*/
+		size_t get_memory_usage() const;
+	};
+
 	class collision_solver
 	{
 		struct implementation;
 		implementation* impl;
 	public:
+		//layer argument of queries and traces which should look at colliders on every layer
+		static constexpr int any_layer = INT_MIN;
 		collision_solver();
 		~collision_solver();
 
@@ -18,11 +73,29 @@ namespace physics
 			makes collider visible to collision detection system
 		*/
 		void register_collider(entities::components::collider* c);
+		/*
+			reserve
+			makes room for additional colliders, so registering a batch of them doesn't grow the pool repeatedly
+		*/
+		void reserve(size_t additional);
 		/*
 			unregister_collider
 			makes collider invisible to collision detection system
 		*/
 		void unregister_collider(entities::components::collider* c);
+		/*
+			update_collider
+			copies collider state to the pool
+			called when collider or its owner changes
+		*/
+		void update_collider(entities::components::collider* c);
+		/*
+			get_pool
+			returns registered colliders
+		*/
+		const colliders_pool& get_pool();
+		collision_stats get_stats();
+		void reset_stats();
 		/*
 			check_if_ray_collide
 			checks if ray of infinite length would hit the collider
@@ -39,6 +112,35 @@ namespace physics
 		*/
 		collision_event* check_if_ray_collide(
 			collision_preset trace_preset, glm::vec2 trace_begin, glm::vec2 trace_dir);
+		/*
+			trace_nearest
+			finds the nearest blocking hit of the segment, walking the spatial grid along it
+			returned event has ignore response when nothing was hit
+		*/
+		collision_event trace_nearest(collision_preset trace_preset, glm::vec2 trace_begin, glm::vec2 trace_end, int layer = any_layer);
+		/*
+			trace_all
+			finds every hit of the segment that isn't ignored, sorted by distance, one per collider
+			-l-
+			[hits]	cleared and filled with the hits
+		*/
+		void trace_all(collision_preset trace_preset, glm::vec2 trace_begin, glm::vec2 trace_end, std::vector<collision_event>& hits,
+			int layer = any_layer);
+		/*
+			trace_batch
+			traces many segments at once, big batches are split between worker threads
+			-l-
+			[segments]	begin and end of every segment, one after another
+			[nearest]	resized to the segments count and filled with results of trace_nearest
+		*/
+		void trace_batch(collision_preset trace_preset, const std::vector<glm::vec2>& segments, std::vector<collision_event>& nearest,
+			int layer = any_layer);
+		/*
+			trace_batch
+			as above, with results of trace_all for every segment
+		*/
+		void trace_batch(collision_preset trace_preset, const std::vector<glm::vec2>& segments, std::vector<std::vector<collision_event>>& hits,
+			int layer = any_layer);
 		/*
 			check_if_collider_collide_on_move
 			checks wheter collider would hit another collider when moved to some location
@@ -50,11 +152,39 @@ namespace physics
 		/*
 			sweep_move
 			simulate collider move to some point
+			hits are ordered by the time of impact, collider moving further than its size is moved in substeps
 			returns structure containing all events that will occur
 			returned event is new allocated and caller takes responsibility for destroying it
 			may return nullptr
 		*/
 		sweep_move_event* sweep_move(
 			entities::components::collider* collider, const glm::vec2& end_point);
+		/*
+			query_box
+			finds colliders overlapping the box, using the spatial grid
+			-l-
+			[filter]	only colliders which don't ignore this preset are returned, 0 returns every collider
+			[result]	cleared and filled with the found colliders
+			[layer]		only colliders on this layer are returned, any_layer returns colliders on every layer
+		*/
+		void query_box(glm::vec2 min, glm::vec2 max, collision_preset filter, std::vector<entities::components::collider*>& result,
+			int layer = any_layer);
+		/*
+			query_circle
+			finds colliders overlapping the circle, using the spatial grid
+			arguments as in query_box
+		*/
+		void query_circle(glm::vec2 center, float radius, collision_preset filter, std::vector<entities::components::collider*>& result,
+			int layer = any_layer);
+		/*
+			nearest
+			returns collider closest to the point, nullptr if there is none within max_distance
+			distance is measured to the collider box, so it is 0 for colliders containing the point
+			-l-
+			[max_distance]	may be infinite, negative or NaN finds nothing
+			[distance]		set to the distance of the returned collider
+		*/
+		entities::components::collider* nearest(glm::vec2 point, float max_distance, collision_preset filter, float& distance,
+			int layer = any_layer);
 	};
 }
\ No newline at end of file
@@ -1,16 +1,29 @@
 #include "dynamics_manager.h"
 #include "source/components/dynamics.h"
+#include "source/entities/entity.h"
 
 #include "source/common/common.h"
-#include <vector>
+#include "source/physics/collision_solver.h"
+
+#include "include/glm/glm.hpp"
 
 using dynamics = entities::components::dynamics;
 
 struct physics::dynamics_manager::implementaion
 {
-	std::vector<dynamics*> all_dynamics;
+	dynamics_pool pool;
+	//colliders found by wake_in_box, reused between calls
+	std::vector<entities::components::collider*> found;
 };
 
+size_t physics::dynamics_pool::get_memory_usage() const
+{
+	return owners.capacity() * sizeof(entities::components::dynamics*)
+		+ (velocities.capacity() + forces.capacity()) * sizeof(glm::vec2)
+		+ (masses.capacity() + drags.capacity() + maximum_velocities.capacity()) * sizeof(float)
+		+ (flags.capacity() + rest_frames.capacity()) * sizeof(uint8_t);
+}
+
 physics::dynamics_manager::dynamics_manager()
 {
 	impl = new implementaion;
@@ -23,20 +36,150 @@ physics::dynamics_manager::~dynamics_manager()
 
 void physics::dynamics_manager::register_dynamics(entities::components::dynamics* dyn)
 {
-	impl->all_dynamics.push_back(dyn);
+	auto& pool = impl->pool;
+	dyn->pool_index = pool.size();
+	pool.owners.push_back(dyn);
+	pool.velocities.push_back({ 0, 0 });
+	pool.forces.push_back({ 0, 0 });
+	pool.masses.push_back(1.0f);
+	pool.drags.push_back(0.7f);
+	pool.maximum_velocities.push_back(0.0f);
+	pool.flags.push_back(common::top_down ? 0 : dynamics_pool::gravity_enabled);
+	pool.rest_frames.push_back(0);
+}
+
+void physics::dynamics_manager::reserve(size_t additional)
+{
+	auto& pool = impl->pool;
+	size_t capacity = pool.size() + additional;
+	pool.owners.reserve(capacity);
+	pool.velocities.reserve(capacity);
+	pool.forces.reserve(capacity);
+	pool.masses.reserve(capacity);
+	pool.drags.reserve(capacity);
+	pool.maximum_velocities.reserve(capacity);
+	pool.flags.reserve(capacity);
+	pool.rest_frames.reserve(capacity);
 }
 
 void physics::dynamics_manager::unregister_dynamics(entities::components::dynamics* dyn)
 {
-	auto itr = std::find(impl->all_dynamics.begin(), impl->all_dynamics.end(), dyn);
-	impl->all_dynamics.erase(itr);
+	auto& pool = impl->pool;
+	size_t index = dyn->pool_index;
+	size_t last = pool.size() - 1;
+	if (pool.flags[index] & dynamics_pool::sleeping)
+		pool.sleeping_count--;
+	if (index != last)
+	{
+		pool.owners[index] = pool.owners[last];
+		pool.velocities[index] = pool.velocities[last];
+		pool.forces[index] = pool.forces[last];
+		pool.masses[index] = pool.masses[last];
+		pool.drags[index] = pool.drags[last];
+		pool.maximum_velocities[index] = pool.maximum_velocities[last];
+		pool.flags[index] = pool.flags[last];
+		pool.rest_frames[index] = pool.rest_frames[last];
+		pool.owners[index]->pool_index = index;
+	}
+	pool.owners.pop_back();
+	pool.velocities.pop_back();
+	pool.forces.pop_back();
+	pool.masses.pop_back();
+	pool.drags.pop_back();
+	pool.maximum_velocities.pop_back();
+	pool.flags.pop_back();
+	pool.rest_frames.pop_back();
 }
 
 void physics::dynamics_manager::update()
 {
-	for (auto& d : impl->all_dynamics)
+	auto& pool = impl->pool;
+	size_t count = pool.size();
+	float time = float(common::delta_time) * common::physics_time_dilation_mod;
+
+	//Apply forces
+	for (size_t i = 0; i < count; i++)
+	{
+		glm::vec2& velocity = pool.velocities[i];
+		glm::vec2& force = pool.forces[i];
+		uint8_t& flags = pool.flags[i];
+		if (flags & dynamics_pool::sleeping)
+			continue;
+
+		//Constrain Velocity
+		if ((flags & dynamics_pool::use_maximum_velocity) && glm::length(velocity) > pool.maximum_velocities[i])
+			velocity = glm::normalize(velocity) * pool.maximum_velocities[i];
+
+		if (common::top_down)
+			velocity -= velocity * float(pool.drags[i] * common::delta_time) * common::physics_time_dilation_mod;
+		else
+			velocity.x -= velocity.x * float(pool.drags[i] * common::delta_time) * common::physics_time_dilation_mod;
+
+		if (glm::length(force) == 0)
+		{
+			if (std::abs(velocity.x) < 0.3f)
+				velocity.x = 0;
+
+			if (std::abs(velocity.y) < 0.3f)
+				velocity.y = 0;
+		}
+
+		if (flags & dynamics_pool::gravity_enabled)
+			force.y -= common::gravitational_acceleration;
+
+		velocity += (force / pool.masses[i]) * time;
+		force = { 0, 0 };
+		flags &= static_cast<uint8_t>(~dynamics_pool::grounded);
+	}
+
+	//Sweep bodies, collisions only queue events, so the pool doesn't change during the loop
+	for (size_t i = 0; i < count; i++)
+	{
+		if (pool.flags[i] & dynamics_pool::sleeping)
+			continue;
+		auto owner = pool.owners[i]->owner;
+		owner->sweep(owner->get_location() + pool.velocities[i] * time);
+	}
+
+	//Bodies which stopped after the sweep rest, and fall asleep after enough frames
+	for (size_t i = 0; i < count; i++)
 	{
-		d->grouned = false;
-		d->sweep();
+		if (pool.flags[i] & dynamics_pool::sleeping)
+			continue;
+		if (pool.velocities[i].x != 0 || pool.velocities[i].y != 0)
+		{
+			pool.rest_frames[i] = 0;
+			continue;
+		}
+		if (++pool.rest_frames[i] >= dynamics_pool::frames_to_sleep)
+		{
+			pool.flags[i] |= dynamics_pool::sleeping;
+			pool.sleeping_count++;
+		}
 	}
-}
\ No newline at end of file
+}
+
+void physics::dynamics_manager::wake(entities::components::dynamics* dyn)
+{
+	auto& pool = impl->pool;
+	size_t index = dyn->pool_index;
+	if (!(pool.flags[index] & dynamics_pool::sleeping))
+		return;
+	pool.rest_frames[index] = 0;
+	pool.flags[index] &= static_cast<uint8_t>(~dynamics_pool::sleeping);
+	pool.sleeping_count--;
+}
+
+void physics::dynamics_manager::wake_in_box(glm::vec2 min, glm::vec2 max)
+{
+	if (impl->pool.sleeping_count == 0)
+		return;
+	common::collision_solver->query_box(min, max, 0, impl->found);
+	for (auto c : impl->found)
+		c->get_owner()->for_each_component<dynamics>([this](dynamics* d) { wake(d); });
+}
+
+physics::dynamics_pool& physics::dynamics_manager::get_pool()
+{
+	return impl->pool;
+}
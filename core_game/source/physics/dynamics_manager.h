@@ -1,4 +1,8 @@
 #pragma once
+#include "include/glm/vec2.hpp"
+
+#include <vector>
+#include <cstdint>
 
 namespace entities
 {
@@ -10,6 +14,39 @@ namespace entities
 
 namespace physics
 {
+	/*
+		dynamics_pool
+		state of all dynamics components in structure of arrays form,
+		component keeps its index in the pool
+	*/
+	struct dynamics_pool
+	{
+		enum flag : uint8_t
+		{
+			gravity_enabled = 1, use_maximum_velocity = 2, grounded = 4, sleeping = 8
+		};
+		//frames a body has to rest before it falls asleep
+		static constexpr uint8_t frames_to_sleep = 30;
+
+		std::vector<entities::components::dynamics*> owners;
+		std::vector<glm::vec2> velocities;
+		std::vector<glm::vec2> forces;
+		std::vector<float> masses;
+		std::vector<float> drags;
+		std::vector<float> maximum_velocities;
+		std::vector<uint8_t> flags;
+		//frames the body has been at rest, up to frames_to_sleep
+		std::vector<uint8_t> rest_frames;
+		size_t sleeping_count = 0;
+
+		size_t size() const { return owners.size(); }
+		/*
+			get_memory_usage
+			returns bytes reserved by the pool
+		*/
+		size_t get_memory_usage() const;
+	};
+
 	class dynamics_manager
 	{
 	private:
@@ -19,7 +56,32 @@ namespace physics
 		dynamics_manager();
 		~dynamics_manager();
 		void register_dynamics(entities::components::dynamics* dynamics);
+		/*
+			reserve
+			makes room for additional bodies, so registering a batch of them doesn't grow the pool repeatedly
+		*/
+		void reserve(size_t additional);
+		/*
+			unregister_dynamics
+			last body is moved into the freed slot
+		*/
 		void unregister_dynamics(entities::components::dynamics* dynamics);
+		/*
+			update
+			integrates forces of all bodies in one pass over the pool, then sweeps them
+		*/
 		void update();
+		/*
+			wake
+			wakes the body, if it's sleeping, so it is updated again
+			sleeping bodies are skipped by the update until they are woken
+		*/
+		void wake(entities::components::dynamics* dynamics);
+		/*
+			wake_in_box
+			wakes bodies of colliders overlapping the box, used when something they could rest on is removed
+		*/
+		void wake_in_box(glm::vec2 min, glm::vec2 max);
+		dynamics_pool& get_pool();
 	};
-}
\ No newline at end of file
+}
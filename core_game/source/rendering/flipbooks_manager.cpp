@@ -23,13 +23,16 @@ rendering::flipbooks_manager::~flipbooks_manager()
 
 void rendering::flipbooks_manager::register_flipbook(entities::components::flipbook* flipbook)
 {
+	flipbook->manager_index = impl->flipbooks.size();
 	impl->flipbooks.push_back(flipbook);
 }
 
 void rendering::flipbooks_manager::unregister_flipbook(entities::components::flipbook* flipbook)
 {
-	auto itr = std::find(impl->flipbooks.begin(), impl->flipbooks.end(), flipbook);
-	impl->flipbooks.erase(itr);
+	auto& flipbooks = impl->flipbooks;
+	flipbooks[flipbook->manager_index] = flipbooks.back();
+	flipbooks[flipbook->manager_index]->manager_index = flipbook->manager_index;
+	flipbooks.pop_back();
 }
 
 void rendering::flipbooks_manager::update()
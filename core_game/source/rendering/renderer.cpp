@@ -220,6 +220,7 @@ void renderer::register_mesh_component(entities::components::mesh* mesh)
         bb->buffer_type = graphics_abstraction::buffer_type::instanced;
 
         implementation::geometry geo;
+        mesh->render_index = 0;
         geo.meshes = { mesh };
         geo.transformations_buffer = reinterpret_cast<graphics_abstraction::buffer*>(impl->api->build(bb));
         geo.should_reload_transformations = true;
@@ -228,6 +229,7 @@ void renderer::register_mesh_component(entities::components::mesh* mesh)
     }
     else
     {
+        mesh->render_index = itr->second.meshes.size();
         itr->second.meshes.push_back(mesh);
         itr->second.should_reload_transformations = true;
     }
@@ -240,13 +242,11 @@ void renderer::unregister_mesh_component(entities::components::mesh* mesh)
     if (p_itr == impl->pipelines.end())
         return;
 
-    auto m_itr = std::find(
-        p_itr->second.meshes.begin(),
-        p_itr->second.meshes.end(),
-        mesh
-    );
-
-    p_itr->second.meshes.erase(m_itr);
+    //swap and pop, order of meshes doesn't matter as the whole transformations buffer is rewritten
+    auto& meshes = p_itr->second.meshes;
+    meshes[mesh->render_index] = meshes.back();
+    meshes[mesh->render_index]->render_index = mesh->render_index;
+    meshes.pop_back();
 
     if (p_itr->second.meshes.size() == 0)
         impl->pipelines.erase(p_itr);
@@ -42,5 +42,17 @@ namespace utilities
 
             return hash;
         }
+
+        //64 bit fnv-1a hash of binary data
+        uint64_t hash_data(const char* data, size_t size)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < size; i++)
+            {
+                hash ^= static_cast<unsigned char>(data[i]);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace utilities
+{
+	/*
+		inline_vector
+		vector that keeps up to inline_capacity items inside itself, and moves them to the heap only when it grows above it
+		order of the items is preserved
+		-l-
+		[T] has to be trivially copyable, items are moved with memcpy
+	*/
+	template<class T, size_t inline_capacity>
+	class inline_vector
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "inline_vector items have to be trivially copyable");
+
+		T inline_items[inline_capacity];
+		T* items = inline_items;
+		size_t count = 0;
+		size_t capacity = inline_capacity;
+	public:
+		inline_vector() = default;
+		inline_vector(const inline_vector&) = delete;
+		inline_vector& operator=(const inline_vector&) = delete;
+		~inline_vector()
+		{
+			if (items != inline_items)
+				delete[] items;
+		}
+
+		void push_back(const T& item)
+		{
+			//item may point into the items, so it is copied before they are reallocated
+			T value = item;
+			if (count == capacity)
+			{
+				T* grown = new T[capacity * 2];
+				std::memcpy(grown, items, count * sizeof(T));
+				if (items != inline_items)
+					delete[] items;
+				items = grown;
+				capacity *= 2;
+			}
+			items[count++] = value;
+		}
+
+		void erase(size_t index)
+		{
+			std::memmove(items + index, items + index + 1, (count - index - 1) * sizeof(T));
+			count--;
+		}
+
+		/*
+			erase_if
+			removes every item matching the predicate
+		*/
+		template<class predicate>
+		void erase_if(predicate pred)
+		{
+			size_t kept = 0;
+			for (size_t i = 0; i < count; i++)
+				if (!pred(items[i]))
+					items[kept++] = items[i];
+			count = kept;
+		}
+
+		void clear() { count = 0; }
+
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+		T& operator[](size_t index) { return items[index]; }
+		const T& operator[](size_t index) const { return items[index]; }
+
+		T* begin() { return items; }
+		T* end() { return items + count; }
+		const T* begin() const { return items; }
+		const T* end() const { return items + count; }
+	};
+}